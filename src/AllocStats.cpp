@@ -0,0 +1,158 @@
+#include "AllocStats.h"
+
+#ifdef ELEVATOR_ALLOC_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+namespace
+{
+  constexpr auto NumberOfTags = static_cast<unsigned int>(AllocStats::Tag::NumberOfTags);
+
+  const char* const TagNames[NumberOfTags] = { "other", "generator", "management", "elevator", "logger" };
+
+  struct Counters
+  {
+    std::uint64_t m_allocations;
+    std::uint64_t m_bytes;
+  };
+
+  // Constant initialized, without constructors: operator new can be called before any dynamic initialization
+  std::atomic<std::uint64_t> allocations[NumberOfTags];
+  std::atomic<std::uint64_t> bytes[NumberOfTags];
+  std::atomic<std::uint64_t> frees;
+
+  Counters marked[NumberOfTags];
+  std::atomic<bool> isMarked;
+  std::chrono::steady_clock::time_point markTime;
+
+  thread_local AllocStats::Tag currentTag = AllocStats::Tag::Other;
+
+  std::uint64_t Load(const std::atomic<std::uint64_t>& value) { return value.load(std::memory_order_relaxed); }
+
+  void* Allocate(std::size_t size)
+  {
+    AllocStats::Record(size);
+
+    if (size == 0)
+      size = 1;
+
+    while (true)
+    {
+      const auto memory = std::malloc(size);
+
+      if (memory != nullptr)
+        return memory;
+
+      const auto handler = std::get_new_handler();
+
+      if (handler == nullptr)
+        throw std::bad_alloc();
+
+      handler();
+    }
+  }
+
+  void Free(void* memory) noexcept
+  {
+    if (memory == nullptr)
+      return;
+
+    frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(memory);
+  }
+
+  std::string ToString(const std::uint64_t count, const std::uint64_t size)
+  {
+    std::ostringstream text;
+    text << count << " allocations, " << size << " bytes";
+    return text.str();
+  }
+}
+
+void AllocStats::Record(const std::size_t size)
+{
+  const auto tag = static_cast<unsigned int>(currentTag);
+
+  allocations[tag].fetch_add(1, std::memory_order_relaxed);
+  bytes[tag].fetch_add(size, std::memory_order_relaxed);
+}
+
+AllocStats::Tag AllocStats::Swap(const Tag tag)
+{
+  const auto previous = currentTag;
+  currentTag = tag;
+  return previous;
+}
+
+void AllocStats::Mark()
+{
+  for (unsigned int tag = 0; tag < NumberOfTags; ++tag)
+    marked[tag] = Counters{ Load(allocations[tag]), Load(bytes[tag]) };
+
+  markTime = std::chrono::steady_clock::now();
+  isMarked = true;
+}
+
+void AllocStats::TraceReport(ILog& log)
+{
+  const auto elapsed = isMarked ? std::chrono::duration<double>(std::chrono::steady_clock::now() - markTime).count() : 0.0;
+
+  std::uint64_t totalAllocations = 0;
+
+  std::stringstream report;
+  report << "Allocation statistics (startup, then steady state since the simulation started)";
+
+  for (unsigned int tag = 0; tag < NumberOfTags; ++tag)
+  {
+    const auto count = Load(allocations[tag]);
+    const auto size = Load(bytes[tag]);
+    const auto startup = isMarked ? marked[tag] : Counters{ count, size };
+
+    report << "\n  " << std::left << std::setw(11) << TagNames[tag] << std::right
+      << " startup: " << ToString(startup.m_allocations, startup.m_bytes)
+      << "; steady state: " << ToString(count - startup.m_allocations, size - startup.m_bytes);
+
+    if (elapsed > 0.0)
+      report << std::fixed << std::setprecision(1) << " (" << (count - startup.m_allocations) / elapsed << "/s)";
+
+    totalAllocations += count;
+  }
+
+  report << "\n  Total: " << totalAllocations << " allocations, " << Load(frees) << " frees";
+
+  log.Trace(report);
+}
+
+// Replaced global allocation functions: every new expression and standard container goes through them
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  try
+  {
+    return Allocate(size);
+  }
+  catch (const std::bad_alloc&)
+  {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+
+void operator delete(void* memory) noexcept { Free(memory); }
+void operator delete[](void* memory) noexcept { Free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { Free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { Free(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept { Free(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept { Free(memory); }
+
+#endif
@@ -0,0 +1,94 @@
+/**********************************************************************************
+*        File: AllocStats.h
+* Description: Heap allocations counted per subsystem, through the replaced global
+*              operator new and the scopes tagging the current thread.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: Enabled only when built with ELEVATOR_ALLOC_STATS (make ALLOC_STATS=1):
+*              otherwise the scopes compile to nothing and operator new is the standard one.
+**********************************************************************************/
+
+#pragma once
+
+#include "ILog.h"
+
+#include <cstddef>
+
+/**
+ * \brief Allocations are attributed to the innermost scope alive on the allocating thread,
+ * Other outside any scope. The strings built by the caller of a trace are counted in the
+ * scope of the caller: only the copies made by the log itself are counted in Logger.
+ */
+class AllocStats final
+{
+public:
+  enum class Tag : unsigned int
+  {
+    Other,
+    Generator,
+    Management,
+    Elevator,
+    Logger,
+    NumberOfTags
+  };
+
+#ifdef ELEVATOR_ALLOC_STATS
+
+  /**
+   * \brief Tag the allocations of the current thread until the destruction.
+   */
+  class Scope final
+  {
+  public:
+    explicit Scope(const Tag tag) : m_previous(Swap(tag)) {}
+    ~Scope() { Swap(m_previous); }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Tag m_previous;
+  };
+
+public:
+  AllocStats() = delete;
+
+  /**
+   * \brief End of the startup: the report shows the following allocations apart, as the steady state.
+   */
+  static void Mark();
+
+  /**
+   * \brief Trace the allocations of every tag, before and after the mark.
+   */
+  static void TraceReport(ILog& log);
+
+  /**
+   * \brief Count an allocation of the current thread; called by operator new.
+   */
+  static void Record(const std::size_t bytes);
+
+private:
+  /**
+   * \brief Set the tag of the current thread, returning the previous one.
+   */
+  static Tag Swap(const Tag tag);
+
+#else
+
+  class Scope final
+  {
+  public:
+    explicit Scope(const Tag) {}
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+public:
+  AllocStats() = delete;
+
+  static void Mark() {}
+  static void TraceReport(ILog&) {}
+
+#endif
+};
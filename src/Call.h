@@ -8,12 +8,28 @@
 #pragma once
 
 #include "Floors.h"
+#include "Checkpoint.h"
 
 #include <utility>
 #include <string>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <cstdint>
 
 class Call final 
 {
+public:
+  /**
+   * \brief Where the passenger is. Changed under the lock of the waiting people, except Transfer.
+   */
+  enum class State : std::uint8_t
+  {
+    Waiting,     // on the floor, for the assigned elevator
+    Travelling,  // inside an elevator
+    Abandoned,   // left the floor, the call is still pending for the elevator
+  };
+
 public:
   explicit Call(const Floors::FloorNumber startFloor = 0, const Floors::FloorNumber destinationFloor = 0) :
     m_startFloor(startFloor), m_destinationFloor(destinationFloor)
@@ -25,31 +41,178 @@ public:
   Call(const Call&) = delete;
   Call& operator=(const Call&) = delete;
 
-  Call(Call&&) = default;
-  Call& operator=(Call&&) = default;
+  Call(Call&&) = delete;
+  Call& operator=(Call&&) = delete;
 
 public:
+  /**
+   * \brief Unique id of the call, in creation order.
+   */
+  std::uint64_t GetId() const { return m_id; }
+
   Floors::FloorNumber GetStartFloor() const { return m_startFloor; }
   Floors::FloorNumber GetDestinationFloor() const { return m_destinationFloor; }
+  Floors::FloorNumber GetFinalDestinationFloor() const { return HasTransfer() ? m_finalDestinationFloor : m_destinationFloor; }
 
   void SetStartFloor(const Floors::FloorNumber startFloor) { m_startFloor = startFloor; }
   void SetDestinationFloor(const Floors::FloorNumber destinationFloor) { m_destinationFloor = destinationFloor; }
 
+  /**
+   * \brief Time of the floor call: the generation of the call or, after a transfer, the arrival on the transfer floor.
+   */
+  std::chrono::steady_clock::time_point GetCallTime() const { return m_callTime; }
+
+  /**
+   * \brief Time of the last assignment to an elevator and of the boarding, for the current journey leg.
+   */
+  std::chrono::steady_clock::time_point GetAssignTime() const { return m_assignTime; }
+  std::chrono::steady_clock::time_point GetBoardTime() const { return m_boardTime; }
+
+  void SetAssignTime(const std::chrono::steady_clock::time_point assignTime) { m_assignTime = assignTime; }
+  void SetBoardTime(const std::chrono::steady_clock::time_point boardTime) { m_boardTime = boardTime; }
+
+  State GetState() const { return m_state.load(std::memory_order_acquire); }
+  void SetState(const State state) { m_state.store(state, std::memory_order_release); }
+
+  /**
+   * \brief Number of times the passenger gave up and called again before this call.
+   */
+  unsigned int GetReCalls() const { return m_reCalls; }
+  void SetReCalls(const unsigned int reCalls) { m_reCalls = reCalls; }
+
   std::string GetAssignedElevator() const { return m_assignedElevator; }
   void SetAssignedElevator(std::string assignedElevator) { m_assignedElevator = std::move(assignedElevator); }
 
+  /**
+   * \brief Split the journey: the call ends on the transfer floor and continues later to the current destination.
+   */
+  void SetTransferFloor(const Floors::FloorNumber transferFloor)
+  {
+    m_finalDestinationFloor = m_destinationFloor;
+    m_destinationFloor = transferFloor;
+  }
+
+  bool HasTransfer() const { return m_finalDestinationFloor != Floors::InvalidFloor; }
+
+  /**
+   * \brief Start the second part of the journey from the transfer floor.
+   */
+  void Transfer()
+  {
+    m_startFloor = m_destinationFloor;
+    m_destinationFloor = m_finalDestinationFloor;
+    m_finalDestinationFloor = Floors::InvalidFloor;
+    m_assignedElevator = "?";
+    m_callTime = std::chrono::steady_clock::now();
+    SetState(State::Waiting); // published after the call time
+  }
+
+  /**
+   * \brief The person leaves a failed elevator on the passed floor and calls again from there.
+   */
+  void Evacuate(const Floors::FloorNumber floor)
+  {
+    m_startFloor = floor;
+    m_assignedElevator = "?";
+    m_callTime = std::chrono::steady_clock::now();
+    SetState(State::Waiting);
+  }
+
+  /**
+   * \brief The call was moved from a failed elevator to another one.
+   */
+  bool IsRedispatched() const { return m_redispatched; }
+  void SetRedispatched() { m_redispatched = true; }
+
+  /**
+   * \brief The call was moved to an elevator serving it sooner, see Configuration::Reallocation.
+   */
+  bool IsReallocated() const { return m_reallocated; }
+  void SetReallocated() { m_reallocated = true; }
+
+  /**
+   * \brief The call was escalated for waiting too long, see Configuration::WaitTimeSlo.
+   */
+  bool IsEscalated() const { return m_escalated; }
+  void SetEscalated() { m_escalated = true; }
+
   Direction GetDirection() const { return m_startFloor < m_destinationFloor ? Direction::Up : Direction::Down; }
 
   bool IsValid() const
     { return Floors::IsValid(m_startFloor) && Floors::IsValid(m_destinationFloor) && m_startFloor != m_destinationFloor; }
 
   std::string ToString() const 
-    { return "[" + m_assignedElevator + " " + std::to_string(m_startFloor) + ", " + std::to_string(m_destinationFloor) + "]"; }
+  {
+    const auto transfer = HasTransfer() ? " > " + std::to_string(m_finalDestinationFloor) : std::string();
+    return "[" + m_assignedElevator + " " + std::to_string(m_startFloor) + ", " + std::to_string(m_destinationFloor) + transfer + "]";
+  }
+
+  void Serialize(CheckpointWriter& writer) const
+  {
+    writer.Write(m_id);
+    writer.Write(m_startFloor);
+    writer.Write(m_destinationFloor);
+    writer.Write(m_finalDestinationFloor);
+    writer.Write(m_callTime);
+    writer.Write(m_assignTime);
+    writer.Write(m_boardTime);
+    writer.Write(m_assignedElevator);
+    writer.Write(GetState());
+    writer.Write(m_reCalls);
+    writer.Write(m_redispatched);
+    writer.Write(m_escalated);
+    writer.Write(m_reallocated);
+  }
+
+  /**
+   * \brief Read a call written by Serialize.
+   * \return The call, nullptr if it cannot be read.
+   */
+  static std::shared_ptr<Call> Deserialize(CheckpointReader& reader)
+  {
+    auto call = std::make_shared<Call>();
+    auto state = State::Waiting;
+
+    const auto good = reader.Read(call->m_id) && reader.Read(call->m_startFloor) && reader.Read(call->m_destinationFloor) && reader.Read(call->m_finalDestinationFloor)
+      && reader.Read(call->m_callTime) && reader.Read(call->m_assignTime) && reader.Read(call->m_boardTime) && reader.Read(call->m_assignedElevator) && reader.Read(state) && reader.Read(call->m_reCalls)
+      && reader.Read(call->m_redispatched) && reader.Read(call->m_escalated) && reader.Read(call->m_reallocated);
+
+    if (!good)
+      return nullptr;
+
+    call->SetState(state);
+
+    // The calls created after the restore continue the sequence of the ids
+    if (NextId() <= call->m_id)
+      NextId() = call->m_id + 1;
+
+    return call;
+  }
+
+private:
+  static std::atomic<std::uint64_t>& NextId()
+  {
+    static std::atomic<std::uint64_t> nextId{ 1 };
+    return nextId;
+  }
 
 private:
+  std::uint64_t m_id = NextId()++;
+
   Floors::FloorNumber m_startFloor = 0;
   Floors::FloorNumber m_destinationFloor = 0;
+  Floors::FloorNumber m_finalDestinationFloor = Floors::InvalidFloor;
+
+  std::chrono::steady_clock::time_point m_callTime = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point m_assignTime;
+  std::chrono::steady_clock::time_point m_boardTime;
 
   std::string m_assignedElevator = "?";
+
+  std::atomic<State> m_state{ State::Waiting };
+  unsigned int m_reCalls = 0;
+  bool m_redispatched = false;
+  bool m_escalated = false;
+  bool m_reallocated = false;
 };
 
@@ -0,0 +1,282 @@
+#include "CallsWriter.h"
+
+#include "Call.h"
+#include "Log.h"
+#include "Configuration.h"
+
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Configuration::CallsOutput;
+
+namespace
+{
+  const char* const ColumnNames[CallsWriter::NumberOfColumns] =
+    { "id", "start_floor", "destination_floor", "elevator", "call_time_us", "assign_time_us", "board_time_us", "exit_time_us" };
+
+  struct Block
+  {
+    std::size_t m_size = 0;
+    std::vector<std::int64_t> m_columns[CallsWriter::NumberOfColumns];
+  };
+
+  struct Writer
+  {
+    std::mutex m_mutex;
+    std::condition_variable m_blockReady;
+    bool m_running = false;
+    bool m_stopRequested = false;
+
+    std::unique_ptr<Block> m_current;              // being filled by the elevators
+    std::deque<std::unique_ptr<Block>> m_full;     // waiting to be written
+    std::vector<std::unique_ptr<Block>> m_free;    // written, to be reused
+    std::size_t m_allocatedBlocks = 0;
+
+    std::uint64_t m_records = 0;
+    std::uint64_t m_dropped = 0;
+    std::uint64_t m_bytes = 0;
+
+    std::ofstream m_file;
+    std::unique_ptr<std::thread> m_thread;
+
+    // Steady clock times are converted to the system clock with the offset at the start
+    std::chrono::system_clock::time_point m_systemStart;
+    std::chrono::steady_clock::time_point m_steadyStart;
+  };
+
+  Writer& GetWriter()
+  {
+    static Writer writer;
+    return writer;
+  }
+
+  void PutUInt32(std::vector<unsigned char>& bytes, const std::uint32_t value)
+  {
+    for (auto shift = 0; shift < 32; shift += 8)
+      bytes.push_back(static_cast<unsigned char>(value >> shift));
+  }
+
+  void PutVarint(std::vector<unsigned char>& bytes, const std::int64_t value)
+  {
+    // Zigzag: small negative and positive values are both small
+    auto encoded = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+
+    while (encoded >= 0x80)
+    {
+      bytes.push_back(static_cast<unsigned char>(encoded | 0x80));
+      encoded >>= 7;
+    }
+
+    bytes.push_back(static_cast<unsigned char>(encoded));
+  }
+
+  /**
+   * \brief Encode the columns of a block: deltas from the previous record or from the call time, see CallsWriter::Column.
+   */
+  void Encode(const Block& block, std::vector<unsigned char>& bytes, std::vector<unsigned char>& column)
+  {
+    bytes.clear();
+    PutUInt32(bytes, static_cast<std::uint32_t>(block.m_size));
+
+    for (unsigned int index = 0; index < CallsWriter::NumberOfColumns; ++index)
+    {
+      const auto& values = block.m_columns[index];
+      const auto& callTimes = block.m_columns[CallsWriter::CallTime];
+
+      column.clear();
+      std::int64_t previous = 0;
+
+      for (std::size_t record = 0; record < block.m_size; ++record)
+      {
+        switch (index)
+        {
+        case CallsWriter::Id:
+        case CallsWriter::CallTime:
+          PutVarint(column, values[record] - previous);
+          previous = values[record];
+          break;
+
+        case CallsWriter::AssignTime:
+        case CallsWriter::BoardTime:
+        case CallsWriter::ExitTime:
+          PutVarint(column, values[record] - callTimes[record]);
+          break;
+
+        default:
+          PutVarint(column, values[record]);
+        }
+      }
+
+      PutUInt32(bytes, static_cast<std::uint32_t>(column.size()));
+      bytes.insert(bytes.end(), column.begin(), column.end());
+    }
+  }
+}
+
+bool CallsWriter::Start(const std::string& fileName)
+{
+  auto& writer = GetWriter();
+  std::lock_guard<std::mutex> lock(writer.m_mutex);
+
+  if (writer.m_running)
+    return true;
+
+  writer.m_file.open(fileName, std::ios::binary | std::ios::trunc);
+
+  if (!writer.m_file)
+  {
+    Log("CallsWriter").Trace("Cannot create " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  std::vector<unsigned char> header;
+  PutUInt32(header, Magic);
+  PutUInt32(header, Version);
+  PutUInt32(header, NumberOfColumns);
+
+  for (const auto name : ColumnNames)
+  {
+    const std::string columnName(name);
+    header.push_back(static_cast<unsigned char>(columnName.size()));
+    header.insert(header.end(), columnName.begin(), columnName.end());
+  }
+
+  writer.m_file.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+  writer.m_bytes = header.size();
+
+  writer.m_systemStart = std::chrono::system_clock::now();
+  writer.m_steadyStart = std::chrono::steady_clock::now();
+  writer.m_stopRequested = false;
+  writer.m_running = true;
+  writer.m_thread = std::make_unique<std::thread>(&CallsWriter::WriterThreadFunction);
+
+  return true;
+}
+
+void CallsWriter::Stop()
+{
+  auto& writer = GetWriter();
+
+  {
+    std::lock_guard<std::mutex> lock(writer.m_mutex);
+
+    if (!writer.m_running)
+      return;
+
+    // The partial block too
+    if (writer.m_current != nullptr && writer.m_current->m_size > 0)
+      writer.m_full.push_back(std::move(writer.m_current));
+
+    writer.m_running = false;
+    writer.m_stopRequested = true;
+  }
+
+  writer.m_blockReady.notify_one();
+  writer.m_thread->join();
+  writer.m_thread.reset();
+  writer.m_file.close();
+
+  Log("CallsWriter").Trace("Records written: " + std::to_string(writer.m_records) + " (" + std::to_string(writer.m_bytes) + " bytes), dropped: "
+    + std::to_string(writer.m_dropped));
+}
+
+void CallsWriter::Record(const Call& call, const unsigned int elevator, const std::chrono::steady_clock::time_point exitTime)
+{
+  if (!Enabled)
+    return;
+
+  auto& writer = GetWriter();
+  std::unique_lock<std::mutex> lock(writer.m_mutex);
+
+  if (!writer.m_running)
+    return;
+
+  if (writer.m_current == nullptr)
+  {
+    if (!writer.m_free.empty())
+    {
+      writer.m_current = std::move(writer.m_free.back());
+      writer.m_free.pop_back();
+    }
+    else if (writer.m_allocatedBlocks < MaxPendingBlocks + 1)
+    {
+      writer.m_current = std::make_unique<Block>();
+
+      for (auto& column : writer.m_current->m_columns)
+        column.resize(BlockSize);
+
+      ++writer.m_allocatedBlocks;
+    }
+    else
+    {
+      // The disk does not keep up: the memory stays bounded
+      ++writer.m_dropped;
+      return;
+    }
+  }
+
+  const auto microseconds = [&writer](const std::chrono::steady_clock::time_point time)
+  {
+    const auto systemTime = writer.m_systemStart + std::chrono::duration_cast<std::chrono::system_clock::duration>(time - writer.m_steadyStart);
+    return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(systemTime.time_since_epoch()).count());
+  };
+
+  auto& block = *writer.m_current;
+  const auto record = block.m_size++;
+
+  block.m_columns[Id][record] = static_cast<std::int64_t>(call.GetId());
+  block.m_columns[StartFloor][record] = call.GetStartFloor();
+  block.m_columns[DestinationFloor][record] = call.GetDestinationFloor();
+  block.m_columns[Elevator][record] = elevator;
+  block.m_columns[CallTime][record] = microseconds(call.GetCallTime());
+  block.m_columns[AssignTime][record] = microseconds(call.GetAssignTime());
+  block.m_columns[BoardTime][record] = microseconds(call.GetBoardTime());
+  block.m_columns[ExitTime][record] = microseconds(exitTime);
+
+  if (block.m_size == BlockSize)
+  {
+    writer.m_full.push_back(std::move(writer.m_current));
+    lock.unlock();
+    writer.m_blockReady.notify_one();
+  }
+}
+
+void CallsWriter::WriterThreadFunction()
+{
+  auto& writer = GetWriter();
+
+  std::vector<unsigned char> bytes;
+  std::vector<unsigned char> column;
+
+  std::unique_lock<std::mutex> lock(writer.m_mutex);
+
+  while (true)
+  {
+    writer.m_blockReady.wait(lock, [&writer]() { return writer.m_stopRequested || !writer.m_full.empty(); });
+
+    if (writer.m_full.empty())
+      break; // stop requested, everything written
+
+    auto block = std::move(writer.m_full.front());
+    writer.m_full.pop_front();
+
+    // Encoded and written without the lock: the elevators fill the next block meanwhile
+    lock.unlock();
+
+    Encode(*block, bytes, column);
+    writer.m_file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+    lock.lock();
+
+    writer.m_records += block->m_size;
+    writer.m_bytes += bytes.size();
+
+    block->m_size = 0;
+    writer.m_free.push_back(std::move(block));
+  }
+}
@@ -0,0 +1,66 @@
+/**********************************************************************************
+*        File: CallsWriter.h
+* Description: Streaming columnar file with a record for every person exited from an
+*              elevator, written by a background thread.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: Memory is bounded: the records exceeding the blocks waiting to be written
+*              are dropped and counted, the elevators never wait for the disk.
+**********************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief Records are buffered column by column in blocks of Configuration::CallsOutput::BlockSize records.
+ *
+ * File layout, little endian:
+ *  - header: uint32 Magic, uint32 Version, uint32 number of columns, then for every column
+ *    uint8 length and the name;
+ *  - blocks: uint32 number of records, then for every column uint32 size in bytes and the values,
+ *    as LEB128 varints of the zigzag encoded deltas (see Column).
+ *
+ * A call with a transfer has a record for every elevator, with the same id.
+ */
+class CallsWriter final
+{
+public:
+  static constexpr std::uint32_t Magic = 0x4C4F4345; // "ECOL"
+  static constexpr std::uint32_t Version = 1;
+
+  enum Column : unsigned int
+  {
+    Id,                // delta from the previous record
+    StartFloor,
+    DestinationFloor,
+    Elevator,          // elevator index
+    CallTime,          // microseconds since the epoch (system clock), delta from the previous record
+    AssignTime,        // microseconds, delta from the call time
+    BoardTime,         // microseconds, delta from the call time
+    ExitTime,          // microseconds, delta from the call time
+    NumberOfColumns
+  };
+
+public:
+  CallsWriter() = delete;
+
+  /**
+   * \brief Create the file and start the writer thread.
+   */
+  static bool Start(const std::string& fileName);
+
+  /**
+   * \brief Write the last block, stop the thread and close the file.
+   */
+  static void Stop();
+
+  /**
+   * \brief Add the record of a person exited from an elevator. Thread safe; does nothing if the writer is not started.
+   */
+  static void Record(const class Call& call, const unsigned int elevator, const std::chrono::steady_clock::time_point exitTime);
+
+private:
+  static void WriterThreadFunction();
+};
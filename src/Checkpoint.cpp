@@ -0,0 +1,111 @@
+#include "Checkpoint.h"
+
+#include "Management.h"
+#include "PeopleCallsGenerator.h"
+#include "Floors.h"
+#include "Log.h"
+#include "Configuration.h"
+
+#include <fstream>
+
+namespace
+{
+  void WriteHeader(CheckpointWriter& writer)
+  {
+    writer.Write(Checkpoint::Magic);
+    writer.Write(Checkpoint::Version);
+    writer.Write(static_cast<std::uint32_t>(Floors::TotalFloors));
+    writer.Write(static_cast<std::uint32_t>(Configuration::Building::NumberOfElevators));
+  }
+
+  bool ReadHeader(CheckpointReader& reader)
+  {
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint32_t numberOfFloors = 0;
+    std::uint32_t numberOfElevators = 0;
+
+    return reader.Read(magic) && reader.Read(version) && reader.Read(numberOfFloors) && reader.Read(numberOfElevators)
+      && magic == Checkpoint::Magic
+      && version == Checkpoint::Version
+      && numberOfFloors == Floors::TotalFloors
+      && numberOfElevators == Configuration::Building::NumberOfElevators;
+  }
+}
+
+bool Checkpoint::Save(const std::string& fileName, Management& management, PeopleCallsGenerator& generator)
+{
+  Log log("Checkpoint");
+
+  std::ofstream file(fileName, std::ios::binary | std::ios::trunc);
+
+  if (!file)
+  {
+    log.Trace("Cannot create " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  log.Trace("Pausing the simulation...", Log::TraceLevel::Verbose);
+
+  // Generator first: no new people while the elevators reach the pause
+  generator.Pause();
+  management.Pause();
+
+  CheckpointWriter writer(file);
+
+  WriteHeader(writer);
+  generator.Serialize(writer);
+  management.Serialize(writer);
+
+  management.Resume();
+  generator.Resume();
+
+  file.flush();
+
+  if (!writer.Good() || !file.good())
+  {
+    log.Trace("Error writing " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  log.Trace("Checkpoint written: " + fileName + " (" + std::to_string(file.tellp()) + " bytes)");
+  return true;
+}
+
+bool Checkpoint::Restore(const std::string& fileName, Management& management, PeopleCallsGenerator& generator)
+{
+  Log log("Checkpoint");
+
+  std::ifstream file(fileName, std::ios::binary);
+
+  if (!file)
+  {
+    log.Trace("Cannot open " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  CheckpointReader reader(file);
+
+  if (!ReadHeader(reader))
+  {
+    log.Trace(fileName + " is not a checkpoint of this building", Log::TraceLevel::Error);
+    return false;
+  }
+
+  generator.Pause();
+  management.Pause();
+
+  const auto restored = generator.Deserialize(reader) && management.Deserialize(reader);
+
+  management.Resume();
+  generator.Resume();
+
+  if (!restored)
+  {
+    log.Trace("Error reading " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  log.Trace("Checkpoint restored: " + fileName);
+  return true;
+}
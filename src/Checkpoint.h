@@ -0,0 +1,161 @@
+/**********************************************************************************
+*        File: Checkpoint.h
+* Description: Binary checkpoint of the whole simulation state.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The values are written in the native byte order and size: a checkpoint
+*              can be restored only by the same build, with the same building.
+**********************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * \brief Writes the values of a checkpoint.
+ */
+class CheckpointWriter final
+{
+public:
+  explicit CheckpointWriter(std::ostream& stream) : m_stream(stream) {}
+
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+public:
+  template<typename T>
+  void Write(const T value)
+  {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only arithmetic and enum values can be written");
+    m_stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  void Write(const std::string& value)
+  {
+    Write(static_cast<std::uint32_t>(value.size()));
+    m_stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+  }
+
+  template<typename T>
+  void Write(const std::vector<T>& values)
+  {
+    Write(static_cast<std::uint32_t>(values.size()));
+
+    for (const auto& value : values)
+      Write(value);
+  }
+
+  /**
+   * \brief Steady clock times are written as the age in milliseconds: they are not meaningful in another process.
+   */
+  void Write(const std::chrono::steady_clock::time_point value)
+  {
+    Write(static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - value).count()));
+  }
+
+  bool Good() const { return m_stream.good(); }
+
+private:
+  std::ostream& m_stream;
+};
+
+/**
+ * \brief Reads the values of a checkpoint. Every function returns 'false' if the value cannot be read.
+ */
+class CheckpointReader final
+{
+public:
+  explicit CheckpointReader(std::istream& stream) : m_stream(stream) {}
+
+  CheckpointReader(const CheckpointReader&) = delete;
+  CheckpointReader& operator=(const CheckpointReader&) = delete;
+
+public:
+  template<typename T>
+  bool Read(T& value)
+  {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Only arithmetic and enum values can be read");
+    return static_cast<bool>(m_stream.read(reinterpret_cast<char*>(&value), sizeof(value)));
+  }
+
+  bool Read(std::string& value)
+  {
+    std::uint32_t size = 0;
+
+    if (!Read(size) || size > MaxStringSize)
+      return false;
+
+    value.resize(size);
+    return size == 0 || static_cast<bool>(m_stream.read(&value[0], size));
+  }
+
+  /**
+   * \brief Read a vector: the size must match the one of the passed vector.
+   */
+  template<typename T>
+  bool Read(std::vector<T>& values)
+  {
+    std::uint32_t size = 0;
+
+    if (!Read(size) || size != values.size())
+      return false;
+
+    for (auto& value : values)
+    {
+      if (!Read(value))
+        return false;
+    }
+
+    return true;
+  }
+
+  /**
+   * \brief Steady clock times are restored from their age.
+   */
+  bool Read(std::chrono::steady_clock::time_point& value)
+  {
+    std::int64_t age = 0;
+
+    if (!Read(age))
+      return false;
+
+    value = std::chrono::steady_clock::now() - std::chrono::milliseconds(age);
+    return true;
+  }
+
+private:
+  static constexpr std::uint32_t MaxStringSize = 1U << 20;
+
+  std::istream& m_stream;
+};
+
+/**
+ * \brief Save and restore the state of the simulation: elevators, stops, waiting and riding people,
+ * dispatcher and calls generator.
+ */
+class Checkpoint final
+{
+public:
+  static constexpr std::uint32_t Magic = 0x4B434C45; // "ELCK"
+  static constexpr std::uint32_t Version = 8;
+
+public:
+  Checkpoint() = delete;
+
+  /**
+   * \brief Pause the simulation on a consistent state, write the checkpoint and resume.
+   * \return 'true' if the checkpoint has been written.
+   */
+  static bool Save(const std::string& fileName, class Management& management, class PeopleCallsGenerator& generator);
+
+  /**
+   * \brief Restore a checkpoint. To be called before starting the calls generator.
+   * \return 'true' if the checkpoint has been restored. On failure the state can be partially restored.
+   */
+  static bool Restore(const std::string& fileName, class Management& management, class PeopleCallsGenerator& generator);
+};
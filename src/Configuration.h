@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <cstddef>
 #include "ILog.h"
 
 using namespace std::chrono_literals;
@@ -28,6 +29,37 @@ namespace Configuration
      * \brief Total number of floors.
      */
     constexpr unsigned int NumberOfFloors = 5;
+
+    /**
+     * \brief Height (m) of the lobby: distance between the bottom floor and the next one.
+     */
+    constexpr double LobbyHeight = 4.5;
+
+    /**
+     * \brief Height (m) of every other floor.
+     */
+    constexpr double FloorHeight = 3.5;
+
+    /**
+     * \brief Range of floors served by a group of elevators. The lobby (bottom floor) is served by every zone.
+     */
+    struct Zone
+    {
+      unsigned int m_lowestFloor;
+      unsigned int m_highestFloor;
+      unsigned int m_numberOfElevators;
+    };
+
+    /**
+     * \brief Enable the zoning: every elevator serves only the floors of its zone plus the lobby.
+     */
+    constexpr bool Zoning = false;
+
+    /**
+     * \brief [With zoning] Zones, the elevators are assigned to them in order. 
+     * Elevators exceeding the zones serve the whole building.
+     */
+    constexpr Zone Zones[] = { { 1, 2, 1 }, { 3, 4, 1 } };
   }
 
   namespace CallsGenerator
@@ -35,7 +67,7 @@ namespace Configuration
     /**
      * \brief Types of calls generators.
      */
-    enum class Type { Fixed, Random };
+    enum class Type { Fixed, Random, Socket };
 
     /**
      * \brief Generator Type.
@@ -61,19 +93,290 @@ namespace Configuration
      * \brief Maximum delay (ms) between random calls.
      */
     constexpr auto MaxDelayBetweenCalls = std::chrono::milliseconds(10s).count();
+
+    /**
+     * \brief [For socket generator] Unix domain socket where another process sends batches of calls.
+     */
+    constexpr const char* SocketPath = "/tmp/elevator_calls.sock";
+
+    /**
+     * \brief [For socket generator] Maximum number of calls in a batch: a longer batch closes the connection.
+     */
+    constexpr unsigned int MaxBatchSize = 4096;
+  }
+
+  namespace Faults
+  {
+    /**
+     * \brief Duration of the injected faults.
+     */
+    constexpr std::chrono::milliseconds OutOfServiceTime = 60s;
+    constexpr std::chrono::milliseconds StuckDoorsTime = 30s;
+    constexpr std::chrono::milliseconds SlowTime = 60s;
+
+    /**
+     * \brief Travel time multiplier of a slow elevator.
+     */
+    constexpr double SlowFactor = 3.0;
+
+    /**
+     * \brief An elevator with the doors stuck longer than this hands its floor calls to the others.
+     */
+    constexpr std::chrono::milliseconds FailoverTimeout = 5s;
+  }
+
+  namespace Passengers
+  {
+    /**
+     * \brief Waiting passengers lose patience: they call again, take the stairs or give up.
+     */
+    constexpr bool Enabled = false;
+
+    /**
+     * \brief Range of the patience of a passenger, uniformly distributed.
+     */
+    constexpr std::chrono::milliseconds MinPatience = 30s;
+    constexpr std::chrono::milliseconds MaxPatience = 120s;
+
+    /**
+     * \brief Probability that an impatient passenger calls again, waiting with a new patience.
+     */
+    constexpr double ReCallProbability = 0.5;
+
+    /**
+     * \brief Calls of a passenger after the first one, then the passenger leaves.
+     */
+    constexpr unsigned int MaxReCalls = 2;
+
+    /**
+     * \brief A passenger leaving takes the stairs for a trip up to this number of floors, otherwise gives up.
+     */
+    constexpr unsigned int StairsMaxFloors = 3;
   }
 
   namespace Elevator
   {
     /**
-     * \brief Time to reach the next floor.
+     * \brief Maximum (rated) speed of the car (m/s).
+     */
+    constexpr double MaxSpeed = 2.5;
+
+    /**
+     * \brief Maximum acceleration and deceleration of the car (m/s^2).
+     */
+    constexpr double Acceleration = 1.0;
+
+    /**
+     * \brief Maximum jerk, the rate of change of the acceleration (m/s^3).
+     */
+    constexpr double Jerk = 1.5;
+
+    /**
+     * \brief Time to open or to close the doors.
      */
-    constexpr std::chrono::milliseconds TimeToReachTheNextFloor = 2s;
+    constexpr std::chrono::milliseconds DoorsOperationTime = 1s;
 
     /**
      * \brief Time for people enter and exit in the elevator
      */
     constexpr std::chrono::milliseconds EnterAndExitTime = 2s;
+
+    /**
+     * \brief Maximum number of people inside the car.
+     */
+    constexpr unsigned int Capacity = 8;
+  }
+
+  namespace Parking
+  {
+    /**
+     * \brief Where the idle elevators wait for the next call.
+     * None: where they stopped; HomeFloor: on the configured home floors; DemandWeighted: on the floors with more calls.
+     */
+    enum class Policy { None, HomeFloor, DemandWeighted };
+
+    /**
+     * \brief Parking policy.
+     */
+    constexpr auto ParkingPolicy = Policy::None;
+
+    /**
+     * \brief Idle time before the elevator moves to the parking floor.
+     */
+    constexpr std::chrono::milliseconds IdleTime = 5s;
+
+    /**
+     * \brief [For HomeFloor policy] Home floor of every elevator, in order. Elevators exceeding the list park in the lobby.
+     */
+    constexpr unsigned int HomeFloors[] = { 0 };
+  }
+
+  namespace Reallocation
+  {
+    /**
+     * \brief Periodically move the waiting calls to an elevator that would serve them clearly sooner.
+     */
+    constexpr bool Enabled = false;
+
+    /**
+     * \brief Period of the reallocation pass.
+     */
+    constexpr std::chrono::milliseconds Period = 2s;
+
+    /**
+     * \brief Minimum gain of the estimated time to serve a call to move it.
+     */
+    constexpr std::chrono::milliseconds MinGain = 5s;
+  }
+
+  namespace WaitTimeSlo
+  {
+    /**
+     * \brief Maximum waiting time, from the floor call to the boarding: every person boarding later is a breach.
+     */
+    constexpr std::chrono::milliseconds MaxWaitTime = 60s;
+
+    /**
+     * \brief Monitor the waiting calls and escalate the ones waiting longer than EscalationTime.
+     */
+    constexpr bool Enabled = false;
+
+    /**
+     * \brief Waiting time after which a call is escalated: moved to a better elevator or, if none is
+     * available, its stop is added to the nearest elevator. A call is escalated once.
+     */
+    constexpr std::chrono::milliseconds EscalationTime = 45s;
+
+    /**
+     * \brief Period of the monitor.
+     */
+    constexpr std::chrono::milliseconds Period = 1s;
+  }
+
+  namespace Forecast
+  {
+    /**
+     * \brief Length of the time-of-day buckets used to forecast the calls.
+     */
+    constexpr std::chrono::minutes BucketDuration = 15min;
+
+    /**
+     * \brief Weight (0-1) of the last occurrence of a bucket in its exponentially weighted average.
+     */
+    constexpr double SmoothingFactor = 0.3;
+  }
+
+  namespace Statistics
+  {
+    /**
+     * \brief Period of the report of the elevators statistics in the log, zero for the final report only.
+     */
+    constexpr std::chrono::milliseconds ReportPeriod = 60s;
+
+    /**
+     * \brief An elevator busier than the bank average by this factor is reported as overloaded,
+     * one less busy by the same factor as underused.
+     */
+    constexpr double ImbalanceFactor = 1.5;
+  }
+
+  namespace Metrics
+  {
+    /**
+     * \brief Publish the live metrics in a shared memory segment readable by other processes.
+     */
+    constexpr bool PublishInSharedMemory = true;
+
+    /**
+     * \brief Name of the shared memory segment.
+     */
+    constexpr const char* SegmentName = "elevator_metrics";
+
+    /**
+     * \brief Serve the metrics in text exposition format on http://127.0.0.1:HttpPort/metrics
+     */
+    constexpr bool HttpEndpoint = false;
+
+    /**
+     * \brief Port of the metrics endpoint.
+     */
+    constexpr unsigned short HttpPort = 9464;
+  }
+
+  namespace Checkpoint
+  {
+    /**
+     * \brief File written by the checkpoint command ('c' + Enter).
+     */
+    constexpr const char* FileName = "Elevator.checkpoint";
+  }
+
+  namespace Journal
+  {
+    /**
+     * \brief Record the simulation events in a memory mapped ring file.
+     */
+    constexpr bool Enabled = true;
+
+    constexpr const char* FileName = "Elevator.journal";
+
+    /**
+     * \brief Events in the ring (32 bytes each): the oldest ones are overwritten.
+     */
+    constexpr std::size_t Capacity = 65536;
+  }
+
+  namespace TraceEvents
+  {
+    /**
+     * \brief Record the timeline of the elevators and write it at shutdown, in the Chrome trace event format.
+     */
+    constexpr bool Enabled = false;
+
+    constexpr const char* FileName = "Elevator.trace.json";
+
+    /**
+     * \brief Events kept per thread (48 bytes each): the following ones are dropped.
+     */
+    constexpr std::size_t MaxEventsPerThread = 1000000;
+  }
+
+  namespace CallsOutput
+  {
+    /**
+     * \brief Stream a record per person delivered (call, assign, board and exit times) to a compressed columnar file.
+     */
+    constexpr bool Enabled = false;
+
+    constexpr const char* FileName = "Elevator.calls";
+
+    /**
+     * \brief Records per block: the unit buffered in memory, encoded and written by the background thread.
+     */
+    constexpr std::size_t BlockSize = 8192;
+
+    /**
+     * \brief Full blocks waiting to be written (64 bytes per record): with the disk behind, the following records are dropped.
+     */
+    constexpr std::size_t MaxPendingBlocks = 16;
+  }
+
+  namespace Dashboard
+  {
+    /**
+     * \brief Show a live view of the building on top of the terminal, with the log scrolling below it.
+     */
+    constexpr bool Enabled = false;
+
+    /**
+     * \brief Period between two frames: only the cells changed since the previous frame are written.
+     */
+    constexpr std::chrono::milliseconds RefreshPeriod = 250ms;
+
+    /**
+     * \brief Log messages below this level are not traced while the dashboard is shown.
+     */
+    constexpr ILog::TraceLevel MessageLevel = ILog::TraceLevel::Warning;
   }
 
   namespace Log
@@ -81,6 +384,34 @@ namespace Configuration
     constexpr ILog::TraceLevel TraceLevel = ILog::TraceLevel::Verbose;
 
     constexpr ILog::LogType DefaultLogType = ILog::LogType::Screen;
+
+    /**
+     * \brief What to do with a new message when the queue is full.
+     */
+    enum class OverflowPolicy
+    {
+      Block,          // wait for the log thread up to BlockTimeout, then drop the new message
+      DropNewest,     // drop the new message
+      DropOldest,     // drop the oldest queued message
+      DropBelowLevel  // drop the new message if below DropLevel, otherwise the oldest queued message below DropLevel (or the oldest one)
+    };
+
+    /**
+     * \brief Maximum number of messages waiting to be traced.
+     */
+    constexpr std::size_t QueueCapacity = 4096;
+
+    constexpr OverflowPolicy QueueOverflowPolicy = OverflowPolicy::DropBelowLevel;
+
+    /**
+     * \brief Messages below this level are the first dropped by the DropBelowLevel policy.
+     */
+    constexpr ILog::TraceLevel DropLevel = ILog::TraceLevel::Warning;
+
+    /**
+     * \brief Maximum wait of the Block policy.
+     */
+    constexpr std::chrono::milliseconds BlockTimeout = 100ms;
   }
 
 }
\ No newline at end of file
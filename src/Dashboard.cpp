@@ -0,0 +1,262 @@
+#include "Dashboard.h"
+#include "Metrics.h"
+#include "Elevator.h"
+#include "Configuration.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#ifndef ENABLE_VIRTUAL_TERMINAL_PROCESSING
+#define ENABLE_VIRTUAL_TERMINAL_PROCESSING 0x0004
+#endif
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+  constexpr std::size_t HeaderRows = 2;
+  constexpr std::size_t FloorColumnsWidth = 17;   // floor number and people waiting Up and Down
+  constexpr std::size_t ElevatorColumnWidth = 6;
+
+  /**
+   * \brief Unchanged characters between two changed runs below which the runs are written as one:
+   *        a cursor movement costs about as much.
+   */
+  constexpr std::size_t MaxGap = 4;
+
+  std::uint64_t Read(const Metrics::Counter& counter) { return counter.load(std::memory_order_relaxed); }
+  std::int64_t Read(const Metrics::Gauge& gauge) { return gauge.load(std::memory_order_relaxed); }
+
+  std::string MoveTo(const std::size_t row, const std::size_t column)
+  {
+    return "\x1b[" + std::to_string(row + 1) + ';' + std::to_string(column + 1) + 'H';
+  }
+
+  unsigned int NumberOfFloors(const Metrics::Segment& segment)
+  {
+    return segment.m_numberOfFloors < Metrics::MaxFloors ? segment.m_numberOfFloors : Metrics::MaxFloors;
+  }
+
+  unsigned int NumberOfElevators(const Metrics::Segment& segment)
+  {
+    return segment.m_numberOfElevators < Metrics::MaxElevators ? segment.m_numberOfElevators : Metrics::MaxElevators;
+  }
+
+  void Write(const std::string& text)
+  {
+    // A single write: the log thread cannot interleave its lines with a frame
+    std::cout << text << std::flush;
+  }
+}
+
+Dashboard::~Dashboard()
+{
+  Stop();
+}
+
+void Dashboard::Start()
+{
+  if (m_thread != nullptr)
+    return;
+
+#ifdef _WIN32
+  const auto console = GetStdHandle(STD_OUTPUT_HANDLE);
+  DWORD mode = 0;
+
+  if (GetConsoleMode(console, &mode))
+    SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+#endif
+
+  const auto logTopRow = HeaderRows + NumberOfFloors(Metrics::Get()) + 1;
+
+  // Clear the screen, keep the log scrolling below the dashboard and move the cursor there
+  Write("\x1b[2J\x1b[" + std::to_string(logTopRow + 1) + "r" + MoveTo(logTopRow, 0));
+
+  m_previousFrame.clear();
+  m_stopRequested = false;
+  m_thread = std::make_unique<std::thread>(&Dashboard::DashboardThreadFunction, this);
+}
+
+void Dashboard::Stop()
+{
+  if (m_thread == nullptr)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopRequested = true;
+  }
+
+  m_stopCondition.notify_all();
+
+  if (m_thread->joinable())
+    m_thread->join();
+
+  m_thread.reset();
+
+  // Reset the scroll region, leaving the cursor where the log is
+  Write("\x1b" "7\x1b[r\x1b" "8");
+}
+
+void Dashboard::DashboardThreadFunction()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  do
+  {
+    const auto frame = Render();
+    const auto changes = Diff(frame);
+
+    if (!changes.empty())
+      Write("\x1b" "7" + changes + "\x1b" "8");
+
+    m_previousFrame = frame;
+
+  } while (!m_stopCondition.wait_for(lock, Configuration::Dashboard::RefreshPeriod, [this]() { return m_stopRequested; }));
+}
+
+/**
+ * \brief Build the rows of the dashboard from the metrics: the header, then the floors from the top one.
+ */
+std::vector<std::string> Dashboard::Render() const
+{
+  const auto& segment = Metrics::Get();
+  const auto numberOfFloors = NumberOfFloors(segment);
+  const auto numberOfElevators = NumberOfElevators(segment);
+
+  std::vector<std::string> frame;
+  frame.reserve(HeaderRows + numberOfFloors);
+
+  char buffer[256];
+
+  const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+  const auto uptime = (now > segment.m_startTime ? now - segment.m_startTime : 0) / 1000;
+
+  std::uint64_t delivered = 0;
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    delivered += Read(segment.m_elevators[index].m_peopleDelivered);
+
+  std::snprintf(buffer, sizeof(buffer), "Up %02u:%02u:%02u | generated %llu | assigned %llu | waiting %lld | delivered %llu | log queue %lld",
+    static_cast<unsigned int>(uptime / 3600), static_cast<unsigned int>(uptime / 60 % 60), static_cast<unsigned int>(uptime % 60),
+    static_cast<unsigned long long>(Read(segment.m_callsGenerated)),
+    static_cast<unsigned long long>(Read(segment.m_callsAssigned)),
+    static_cast<long long>(Read(segment.m_peopleWaiting)),
+    static_cast<unsigned long long>(delivered),
+    static_cast<long long>(Read(segment.m_logQueueDepth)));
+  frame.emplace_back(buffer);
+
+  std::string columns = "Floor   Up Down  ";
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+  {
+    columns += "  ";
+    columns += static_cast<char>('A' + index);
+    columns.append(ElevatorColumnWidth - 3, ' ');
+  }
+  frame.push_back(std::move(columns));
+
+  for (auto floor = static_cast<int>(numberOfFloors) - 1; floor >= 0; --floor)
+  {
+    const auto& waiting = segment.m_floors[floor].m_waiting;
+    const auto up = Read(waiting[0]);
+    const auto down = Read(waiting[1]);
+
+    std::string row(FloorColumnsWidth, ' ');
+    std::snprintf(buffer, sizeof(buffer), "%5d", floor);
+    row.replace(0, 5, buffer);
+
+    if (up > 0)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%4lld", static_cast<long long>(up));
+      row.replace(6, 4, buffer);
+    }
+
+    if (down > 0)
+    {
+      std::snprintf(buffer, sizeof(buffer), "%4lld", static_cast<long long>(down));
+      row.replace(11, 4, buffer);
+    }
+
+    for (unsigned int index = 0; index < numberOfElevators; ++index)
+    {
+      const auto& elevator = segment.m_elevators[index];
+
+      if (Read(elevator.m_floor) == floor)
+      {
+        auto arrow = '-';
+
+        if (static_cast<ElevatorStatus>(Read(elevator.m_status)) == ElevatorStatus::OutOfOrder)
+          arrow = 'x';
+        else if (static_cast<Direction>(Read(elevator.m_direction)) == Direction::Up)
+          arrow = '^';
+        else if (static_cast<Direction>(Read(elevator.m_direction)) == Direction::Down)
+          arrow = 'v';
+
+        std::snprintf(buffer, sizeof(buffer), "[%2lld%c] ", static_cast<long long>(Read(elevator.m_load) % 100), arrow);
+        row += buffer;
+      }
+      else
+      {
+        const auto stop = floor < 64 && (static_cast<std::uint64_t>(Read(elevator.m_stops)) >> floor & 1) != 0;
+        row += stop ? "  *   " : "  |   ";
+      }
+    }
+
+    frame.push_back(std::move(row));
+  }
+
+  return frame;
+}
+
+/**
+ * \brief Escape sequences turning the previous frame into the given one.
+ */
+std::string Dashboard::Diff(const std::vector<std::string>& frame) const
+{
+  std::string changes;
+
+  for (std::size_t rowIndex = 0; rowIndex < frame.size(); ++rowIndex)
+  {
+    const auto& previous = rowIndex < m_previousFrame.size() ? m_previousFrame[rowIndex] : std::string();
+    auto row = frame[rowIndex];
+
+    // A shorter row blanks the tail of the previous one
+    if (row.size() < previous.size())
+      row.append(previous.size() - row.size(), ' ');
+
+    const auto changed = [&previous, &row](const std::size_t column)
+    {
+      return column >= previous.size() || previous[column] != row[column];
+    };
+
+    std::size_t column = 0;
+
+    while (column < row.size())
+    {
+      if (!changed(column))
+      {
+        ++column;
+        continue;
+      }
+
+      const auto start = column;
+      auto end = column + 1;
+
+      // Extend the run over the next changes, if close enough
+      for (auto next = end; next < row.size() && next - end <= MaxGap; ++next)
+      {
+        if (changed(next))
+          end = next + 1;
+      }
+
+      changes += MoveTo(rowIndex, start);
+      changes.append(row, start, end - start);
+      column = end;
+    }
+  }
+
+  return changes;
+}
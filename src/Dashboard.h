@@ -0,0 +1,58 @@
+/**********************************************************************************
+*        File: Dashboard.h
+* Description: Live terminal view of the elevators, redrawn at a fixed rate.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The dashboard reads only the metrics segment. The terminal must support
+*              the ANSI escape sequences (VT100).
+**********************************************************************************/
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Draws the building in the top rows of the terminal: one row per floor, with the people waiting
+ *        and a column per elevator showing the car, its load and direction, and its stops.
+ *
+ * Each frame is compared with the previous one and only the changed cells are written, with cursor
+ * movements, in a single write. The log keeps scrolling in the rows below the dashboard.
+ */
+class Dashboard final
+{
+public:
+  Dashboard() = default;
+  ~Dashboard();
+
+  Dashboard(const Dashboard&) = delete;
+  Dashboard(Dashboard&&) = delete;
+
+  Dashboard& operator=(const Dashboard&) = delete;
+  Dashboard& operator=(Dashboard&&) = delete;
+
+public:
+  void Start();
+
+  /**
+   * \brief Stop the refresh and give the whole terminal back to the log.
+   */
+  void Stop();
+
+private:
+  void DashboardThreadFunction();
+
+  std::vector<std::string> Render() const;
+  std::string Diff(const std::vector<std::string>& frame) const;
+
+private:
+  std::vector<std::string> m_previousFrame;
+
+  std::unique_ptr<std::thread> m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_stopCondition;
+  bool m_stopRequested = false;
+};
@@ -0,0 +1,140 @@
+#include "DemandForecast.h"
+
+#include "Call.h"
+#include "Configuration.h"
+#include "Checkpoint.h"
+
+#include <algorithm>
+#include <ctime>
+
+using namespace Configuration::Forecast;
+
+namespace
+{
+  constexpr long long BucketsPerDay = std::chrono::hours(24) / BucketDuration;
+  constexpr double BucketsPerHour = std::chrono::duration<double>(std::chrono::hours(1)) / BucketDuration;
+
+  /**
+   * \brief Offset of the local time from UTC, now.
+   */
+  std::chrono::seconds GetUtcOffset()
+  {
+    const auto now = std::time(nullptr);
+    std::tm local{};
+    std::tm utc{};
+
+#ifdef _WIN32
+    localtime_s(&local, &now);
+    gmtime_s(&utc, &now);
+#else
+    localtime_r(&now, &local);
+    gmtime_r(&now, &utc);
+#endif
+
+    // The UTC fields read as a local time are behind (or ahead) by the offset
+    utc.tm_isdst = local.tm_isdst;
+    return std::chrono::seconds(static_cast<long long>(std::difftime(std::mktime(&local), std::mktime(&utc))));
+  }
+}
+
+DemandForecast::DemandForecast() : m_utcOffset(std::chrono::duration_cast<Clock::duration>(GetUtcOffset()))
+{
+  m_averageRates.resize(static_cast<std::size_t>(BucketsPerDay) * Cells);
+  m_bucketSeen.resize(static_cast<std::size_t>(BucketsPerDay));
+  m_counts.resize(Cells);
+}
+
+void DemandForecast::Record(const Call& call)
+{
+  if (!call.IsValid())
+    return;
+
+  Update(Clock::now());
+  ++m_counts[Cell(call.GetStartFloor(), call.GetDirection())];
+}
+
+double DemandForecast::GetRate(const Floors::FloorNumber floor, const Direction direction)
+{
+  if (!Floors::IsValid(floor))
+    return 0.0;
+
+  if (direction != Direction::Up && direction != Direction::Down)
+    return GetRate(floor, Direction::Up) + GetRate(floor, Direction::Down);
+
+  const auto now = Clock::now();
+  Update(now);
+
+  const auto bucket = static_cast<std::size_t>(m_currentBucket % BucketsPerDay);
+  const auto cell = Cell(floor, direction);
+
+  // Live rate of the current bucket, at least one minute is considered to limit the noise at the beginning
+  const auto elapsed = std::max<Clock::duration>(now - m_currentBucketStart, std::chrono::minutes(1));
+  const auto liveRate = m_counts[cell] / std::chrono::duration<double, std::ratio<3600>>(elapsed).count();
+
+  if (!m_bucketSeen[bucket])
+    return liveRate;
+
+  // The more the bucket is elapsed the more the live rate is reliable
+  const auto weight = std::min(std::chrono::duration<double>(elapsed) / BucketDuration, 1.0);
+
+  return weight * liveRate + (1.0 - weight) * m_averageRates[bucket * Cells + cell];
+}
+
+/**
+ * \brief On a bucket change fold the counters of the ended bucket, and of the buckets without calls, in the averages.
+ */
+void DemandForecast::Update(const Clock::time_point now)
+{
+  const auto bucket = static_cast<long long>((now.time_since_epoch() + m_utcOffset) / BucketDuration);
+
+  if (bucket == m_currentBucket)
+    return;
+
+  if (m_currentBucket >= 0)
+  {
+    Fold(static_cast<std::size_t>(m_currentBucket % BucketsPerDay), false);
+
+    const auto skipped = std::min(bucket - m_currentBucket - 1, BucketsPerDay);
+
+    for (auto skippedBucket = 1LL; skippedBucket <= skipped; ++skippedBucket)
+      Fold(static_cast<std::size_t>((m_currentBucket + skippedBucket) % BucketsPerDay), true);
+  }
+
+  m_currentBucket = bucket;
+  m_currentBucketStart = Clock::time_point(std::chrono::duration_cast<Clock::duration>(bucket * BucketDuration) - m_utcOffset);
+
+  std::fill(m_counts.begin(), m_counts.end(), 0U);
+}
+
+void DemandForecast::Fold(const std::size_t bucket, const bool empty)
+{
+  for (std::size_t cell = 0; cell < Cells; ++cell)
+  {
+    const auto rate = empty ? 0.0 : m_counts[cell] * BucketsPerHour;
+    auto& average = m_averageRates[bucket * Cells + cell];
+
+    average = m_bucketSeen[bucket] ? SmoothingFactor * rate + (1.0 - SmoothingFactor) * average : rate;
+  }
+
+  m_bucketSeen[bucket] = 1;
+}
+
+void DemandForecast::Serialize(CheckpointWriter& writer) const
+{
+  writer.Write(m_averageRates);
+  writer.Write(m_bucketSeen);
+  writer.Write(m_counts);
+  writer.Write(m_currentBucket);
+  writer.Write(static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(m_currentBucketStart.time_since_epoch()).count()));
+}
+
+bool DemandForecast::Deserialize(CheckpointReader& reader)
+{
+  std::int64_t currentBucketStart = 0;
+
+  if (!reader.Read(m_averageRates) || !reader.Read(m_bucketSeen) || !reader.Read(m_counts) || !reader.Read(m_currentBucket) || !reader.Read(currentBucketStart))
+    return false;
+
+  m_currentBucketStart = Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::milliseconds(currentBucketStart)));
+  return true;
+}
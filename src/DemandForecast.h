@@ -0,0 +1,73 @@
+/**********************************************************************************
+*        File: DemandForecast.h
+* Description: Online forecast of the calls per floor, direction and time of day.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes:
+**********************************************************************************/
+
+#pragma once
+
+#include "Floors.h"
+
+#include <chrono>
+#include <vector>
+
+/**
+ * \brief Online estimator of the calls arrival rate per floor, direction and time-of-day bucket.
+ * Every bucket keeps an exponentially weighted average of the rates observed in its past occurrences
+ * (i.e. the previous days), blended with the live rate of the current bucket.
+ * Record and GetRate are O(1) within a bucket; the first call after a bucket change folds the ended
+ * bucket and the skipped ones, up to a whole day of buckets after a long idle gap (O(BucketsPerDay * Cells)).
+ * The buckets are in local time of day, with the UTC offset read at the construction (a daylight saving
+ * change during the run shifts them by an hour). The memory footprint is fixed.
+ * Not thread safe: the owner must serialize the calls.
+ */
+class DemandForecast final
+{
+public:
+  DemandForecast();
+  ~DemandForecast() = default;
+
+  DemandForecast(const DemandForecast&) = delete;
+  DemandForecast(DemandForecast&&) = delete;
+
+  DemandForecast& operator=(const DemandForecast&) = delete;
+  DemandForecast& operator=(DemandForecast&&) = delete;
+
+public:
+  /**
+   * \brief Record a new call.
+   */
+  void Record(const class Call& call);
+
+  /**
+   * \brief Forecast of the calls arrival rate.
+   * \param floor Start floor of the calls.
+   * \param direction Direction of the calls, Direction::Both for the total of the floor.
+   * \return Calls per hour.
+   */
+  double GetRate(const Floors::FloorNumber floor, const Direction direction = Direction::Both);
+
+  void Serialize(class CheckpointWriter& writer) const;
+  bool Deserialize(class CheckpointReader& reader);
+
+private:
+  typedef std::chrono::system_clock Clock;
+
+  void Update(const Clock::time_point now);
+  void Fold(const std::size_t bucket, const bool empty);
+
+  static std::size_t Cell(const Floors::FloorNumber floor, const Direction direction)
+    { return floor * 2U + (direction == Direction::Up ? 0U : 1U); }
+
+private:
+  static constexpr std::size_t Cells = Floors::TotalFloors * 2U;
+
+  std::vector<double> m_averageRates;      // [bucket][floor][direction], calls per hour
+  std::vector<unsigned char> m_bucketSeen; // [bucket], the bucket has at least one past occurrence
+  std::vector<unsigned int> m_counts;      // [floor][direction], calls in the current bucket
+
+  long long m_currentBucket = -1;          // buckets since the clock epoch, in local time
+  Clock::time_point m_currentBucketStart;
+  Clock::duration m_utcOffset;             // local time minus UTC
+};
@@ -1,15 +1,42 @@
 #include "Elevator.h"
 #include "Log.h"
 #include "Watchdog.h"
+#include "TravelTimes.h"
 #include "Configuration.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "ElevatorTable.h"
+#include "TraceEvents.h"
+#include "CallsWriter.h"
+#include "AllocStats.h"
 
 using namespace Configuration::Elevator;
 
-Elevator::Elevator(const std::string& id)
+namespace
+{
+  std::string FaultName(const ElevatorFault fault)
+  {
+    switch (fault)
+    {
+    case ElevatorFault::OutOfService: return "out of service";
+    case ElevatorFault::StuckDoors: return "stuck doors";
+    case ElevatorFault::Slow: return "slow";
+    case ElevatorFault::None:
+    default: return "none";
+    }
+  }
+}
+
+Elevator::Elevator(const std::string& id, const unsigned int index) : m_index(index), m_metrics(Metrics::GetElevator(index))
 {
   SetId(id);
 
-  m_thread = std::make_unique<std::thread>(&Elevator::ElevatorThreadFunction, this);
+  m_floors.SetStopsGauge(&m_metrics.m_stops);
+  m_statusSince = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  Metrics::Set(m_metrics.m_floor, m_currentFloor);
+  Metrics::Set(m_metrics.m_direction, static_cast<std::int64_t>(m_currentDirection));
+  Metrics::Set(m_metrics.m_status, static_cast<std::int64_t>(m_status));
 }
 
 Elevator::~Elevator()
@@ -17,9 +44,16 @@ Elevator::~Elevator()
   ShutDown();
 }
 
+void Elevator::Start()
+{
+  if (m_thread == nullptr)
+    m_thread = std::make_unique<std::thread>(&Elevator::ElevatorThreadFunction, this);
+}
+
 void Elevator::Stop()
 {
-  m_status = ElevatorStatus::Idle;
+  SetStatus(ElevatorStatus::Idle);
+  Metrics::Increment(m_metrics.m_stopsMade);
   m_log.Trace("Stopped");
 
   OpenDoors();
@@ -36,23 +70,42 @@ bool Elevator::AnswerToCall(const std::shared_ptr<Call>& call)
     return false;
   }
 
+  // The stop must be set before the call is assigned: once assigned the person can enter
   m_floors.SetStop(call);
+  call->SetAssignTime(std::chrono::steady_clock::now());
+  call->SetAssignedElevator(m_elevatorId);
+
   m_floors.Trace(m_currentFloor);
 
-  if (m_currentDirection == Direction::None)
-    m_currentDirection = call->GetDirection();
+  // Taken by the elevator thread when it starts the run: the direction and its lane in the table have a single writer
+  auto none = Direction::None;
+  m_requestedDirection.compare_exchange_strong(none, call->GetDirection());
+
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+  }
 
   m_go.notify_all();
   return true;
 }
 
+void Elevator::WithdrawCall(const std::shared_ptr<Call>& call)
+{
+  m_floors.CallCancelled(call);
+  m_log.Trace("Call withdrawn " + call->ToString());
+}
+
 void Elevator::ElevatorThreadFunction()
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Elevator);
+
   m_log.Trace("Working", Log::TraceLevel::Verbose);
   m_working = true;
 
   do
   {
+    auto busySince = std::chrono::steady_clock::now();
+
     CloseDoors();
     m_log.Trace("Waiting...");
 
@@ -62,36 +115,97 @@ void Elevator::ElevatorThreadFunction()
     if (m_shutdownRequested)
       break;
 
-    std::unique_lock<std::mutex> lock(m_goMutex);
-    m_go.wait(lock);
+    AddBusyTime(busySince);
+
+    if (m_availableFunction)
+      m_availableFunction(*this);
+
+    {
+      InstrumentedMutex::UniqueLock lock(m_goMutex);
+      const auto stopsOrShutdown = [this]()
+        { return m_shutdownRequested || m_pauseRequested || m_fault == ElevatorFault::OutOfService || m_floors.HasStops(); };
+
+      if (m_parked || !m_parkingFunction || Configuration::Parking::ParkingPolicy == Configuration::Parking::Policy::None)
+      {
+        m_go.wait(lock, stopsOrShutdown);
+      }
+      else if (!m_go.wait_for(lock, Configuration::Parking::IdleTime, stopsOrShutdown))
+      {
+        lock.unlock();
+
+        busySince = std::chrono::steady_clock::now();
+        Park();
+        AddBusyTime(busySince);
+        continue;
+      }
+    }
+
+    // Paused while idle: after the resume (or a restore) there can be stops to serve
+    WaitWhilePaused();
 
-    auto nextFloor = m_floors.GetNextStop(m_currentFloor, m_currentDirection);
+    if (GetFault() == ElevatorFault::OutOfService)
+    {
+      GoOutOfService();
+      continue;
+    }
+
+    busySince = std::chrono::steady_clock::now();
+
+    const auto requestedDirection = m_requestedDirection.exchange(Direction::None);
+
+    if (m_currentDirection == Direction::None)
+      m_currentDirection = requestedDirection;
+
+    auto nextFloor = GetNextStop();
 
     while (Floors::IsValid(nextFloor) && !m_shutdownRequested) // continue until there are stops in current direction and shutdown is not requested
     {
+      m_parked = false;
+
       m_log.Trace(m_currentDirection == Direction::Up ? "Current direction: UP" : "Current direction: DOWN");
+      PublishDirection();
+
+      if (m_availableFunction)
+        m_availableFunction(*this);
 
       if (nextFloor != m_currentFloor)
-      {
         Move(nextFloor);
-      }
-      else
+
+      if (GetFault() == ElevatorFault::OutOfService)
       {
-        m_floors.ClearStop(m_currentFloor, m_currentDirection);
+        GoOutOfService();
+        break;
       }
 
       PeopleEnterAndExit();
+      AddBusyTime(busySince);
 
-      nextFloor = m_floors.GetNextStop(m_currentFloor, m_currentDirection);
+      WaitWhilePaused();
+      busySince = std::chrono::steady_clock::now();
+
+      nextFloor = GetNextStop();
     }
 
     m_currentDirection = Direction::None;
+    m_requestedDirection = Direction::None;  // of calls already served
+    PublishDirection();
+
+    AddBusyTime(busySince);
   } while (!m_shutdownRequested);
 
   m_working = false;
   m_log.Trace("Thread exit", ILog::TraceLevel::Debug);
 }
 
+/**
+ * \brief Next floor to reach: a full elevator skips the floors calls and goes to
+ * the nearest destination of the people inside.
+ */
+Floors::FloorNumber Elevator::GetNextStop()
+{
+  return m_floors.GetNextStop(m_currentFloor, m_currentDirection, !IsFull());
+}
+
 bool Elevator::OpenDoors()
 {
   if (m_status != ElevatorStatus::Idle)
@@ -102,8 +216,13 @@ bool Elevator::OpenDoors()
 
   if (m_doorsStatus == DoorsStatus::Closed)
   {
-    std::this_thread::sleep_for(1s);
+    TraceEvents::Span span("Doors opening", m_index, m_currentFloor);
+
+    WaitWhileDoorsStuck();
+    std::this_thread::sleep_for(DoorsOperationTime);
     m_doorsStatus = DoorsStatus::Open;
+    Metrics::Increment(m_metrics.m_doorCycles);
+    Journal::Record(Journal::EventType::DoorsOpened, m_index, m_currentFloor);
     m_log.Trace("Doors open", Log::TraceLevel::Verbose);
   }
 
@@ -120,8 +239,12 @@ bool Elevator::CloseDoors()
 
   if (m_doorsStatus == DoorsStatus::Open)
   {
-    std::this_thread::sleep_for(1s);
+    TraceEvents::Span span("Doors closing", m_index, m_currentFloor);
+
+    WaitWhileDoorsStuck();
+    std::this_thread::sleep_for(DoorsOperationTime);
     m_doorsStatus = DoorsStatus::Closed;
+    Journal::Record(Journal::EventType::DoorsClosed, m_index, m_currentFloor);
     m_log.Trace("Doors closed", Log::TraceLevel::Verbose);
   }
 
@@ -130,79 +253,248 @@ bool Elevator::CloseDoors()
 
 void Elevator::PeopleEnterAndExit()
 {
+  TraceEvents::Span span("Boarding", m_index, m_currentFloor);
+
   const auto previousStatus = m_status;
-  m_status = ElevatorStatus::PeopleEnterAndExit;
+  SetStatus(ElevatorStatus::PeopleEnterAndExit);
 
   m_log.Trace("People Enter and Exit...", Log::TraceLevel::Verbose);
 
-  m_people.EnterAndExit(Floors::GetPeople(), m_currentFloor, m_currentDirection, m_elevatorId);
+  std::list<std::shared_ptr<Call>> entered;
+  std::list<std::shared_ptr<Call>> exited;
+
+  // The floor calls of the people who did not fit are still counted and will be served later
+  const auto leftBehind = m_people.EnterAndExit(Floors::GetPeople(), m_floors, m_currentFloor, m_currentDirection, m_elevatorId, Capacity, entered, exited);
+  m_load = static_cast<unsigned int>(m_people.Size());
+
+  Metrics::Set(m_metrics.m_load, m_load);
+  Mirror();
+  Metrics::Increment(m_metrics.m_peopleBoarded, entered.size());
+
+  const auto now = std::chrono::steady_clock::now();
+
+  for (const auto& person : exited)
+    Journal::Record(Journal::EventType::PersonAlighted, m_index, m_currentFloor, person->GetId());
+
+  for (const auto& person : entered)
+  {
+    Journal::Record(Journal::EventType::PersonBoarded, m_index, m_currentFloor, person->GetId());
+    person->SetBoardTime(now);
+
+    const auto waitTime = std::chrono::duration_cast<std::chrono::milliseconds>(now - person->GetCallTime());
+    Metrics::Observe(m_metrics.m_waitTime, static_cast<std::uint64_t>(waitTime.count()));
+
+    if (waitTime > Configuration::WaitTimeSlo::MaxWaitTime)
+      Metrics::Increment(m_metrics.m_sloBreaches);
+
+    if (person->IsRedispatched())
+      Metrics::Observe(m_metrics.m_redispatchedWaitTime, static_cast<std::uint64_t>(waitTime.count()));
 
-  RestoreDestinationStops();
+    if (person->IsReallocated())
+      Metrics::Observe(m_metrics.m_reallocatedWaitTime, static_cast<std::uint64_t>(waitTime.count()));
+  }
+
+  if (leftBehind > 0)
+    m_log.Trace("Full, " + std::to_string(leftBehind) + " people left on the floor", Log::TraceLevel::Verbose);
+
+  Deliver(exited);
 
   std::this_thread::sleep_for(EnterAndExitTime);
 
-  m_status = previousStatus;
+  SetStatus(previousStatus);
 }
 
 /**
- * \brief This function ensures that every time a person (call) enters the elevator,
- * the destination is correctly (re)set in the floors stops array.
+ * \brief The people exited continue the journey, if with a transfer, or are delivered.
  */
-void Elevator::RestoreDestinationStops()
-{
-  // This is a workaround.
-  // When a call is assigned the stops are set in the floor array and 
-  // cleared once reached the start or destination floor; this mechanism can fail in some cases:
-  // imagine that the elevator is managing a first call from floor 6 to 1
-  // and while is moving from 6 to 1, another call arrives from floor 8 to 1;
-  // once reached the floor 1 the stop is cleared, but the second call is still to be managed,
-  // so in the next step the elevator go to floor 8, but the destination has been lost and 
-  // people remain in the elevator.
-  // An alternative solution could be to implement a sort of reference counting of the floors stops
-  // but this is the simplest solution.
-
-  // Refresh the stops based on the people inside
-  for (auto& person : m_people.GetList())
+void Elevator::Deliver(const std::list<std::shared_ptr<Call>>& exited)
+{
+  const auto now = std::chrono::steady_clock::now();
+
+  for (const auto& person : exited)
   {
-    if (person->GetDestinationFloor() != m_currentFloor)
+    // Before the transfer: the next elevator sets new assign and board times
+    CallsWriter::Record(*person, m_index, now);
+
+    if (person->HasTransfer() && m_transferFunction)
+      m_transferFunction(person);
+    else
     {
-      m_log.Trace("Restored stop " + person->ToString(), Log::TraceLevel::Debug);
-      m_floors.SetStop(person, true);
+      ++m_statistics.m_peopleDelivered;
+      Metrics::Increment(m_metrics.m_peopleDelivered);
     }
   }
 }
 
-void Elevator::Move(const Floors::FloorNumber requestedFloor)
+/**
+ * \brief Move to the parking floor, if different from the current one.
+ */
+void Elevator::Park()
+{
+  const auto parkingFloor = m_parkingFunction(*this);
+  m_parked = true;
+
+  if (!Floors::IsValid(parkingFloor) || parkingFloor == m_currentFloor)
+    return;
+
+  m_log.Trace("Parking on floor " + std::to_string(parkingFloor));
+  Move(parkingFloor, true);
+}
+
+/**
+ * \brief Move to the requested floor.
+ * \param requestedFloor Floor to reach.
+ * \param parking If true the doors are not opened and the move is interrupted on the next floor if a call arrives.
+ */
+void Elevator::Move(const Floors::FloorNumber requestedFloor, const bool parking)
 {
   if (requestedFloor != m_currentFloor)
   {
     CloseDoors();
 
+    TraceEvents::Span span(parking ? "Parking" : "Moving", m_index, m_currentFloor);
+
+    // The position is updated floor by floor: every step lasts the marginal time of the run
+    // so that the whole run lasts exactly as the precomputed one.
+    const auto startFloor = m_currentFloor;
+
+    if (startFloor == Floors::Lobby)
+    {
+      m_lobbyDepartureTime = std::chrono::steady_clock::now();
+      m_roundTripStarted = true;
+    }
+
+    const auto travel = [this](const std::chrono::milliseconds step)
+    {
+      if (GetFault() == ElevatorFault::Slow)
+        std::this_thread::sleep_for(std::chrono::duration_cast<std::chrono::milliseconds>(step * Configuration::Faults::SlowFactor));
+      else
+        std::this_thread::sleep_for(step);
+    };
+
     do
     {
-      m_status = ElevatorStatus::Moving;
+      SetStatus(ElevatorStatus::Moving);
 
       if (requestedFloor > m_currentFloor && m_currentFloor < Floors::TopFloor)
       {
         m_log.Trace("Moving Up [" + std::to_string(m_currentFloor) + "]", Log::TraceLevel::Verbose);
-        std::this_thread::sleep_for(TimeToReachTheNextFloor);
+        travel(TravelTimes::Get(startFloor, m_currentFloor + 1) - TravelTimes::Get(startFloor, m_currentFloor));
         ++m_currentFloor;
+        Metrics::Set(m_metrics.m_floor, m_currentFloor);
+        Metrics::Increment(m_metrics.m_floorsTravelled);
+        Mirror();
+        Journal::Record(Journal::EventType::FloorReached, m_index, m_currentFloor);
       }
       else if (requestedFloor < m_currentFloor && m_currentFloor > 0)
       {
         m_log.Trace("Moving Down [" + std::to_string(m_currentFloor) + "]", Log::TraceLevel::Verbose);
-        std::this_thread::sleep_for(TimeToReachTheNextFloor);
+        travel(TravelTimes::Get(startFloor, m_currentFloor - 1) - TravelTimes::Get(startFloor, m_currentFloor));
         --m_currentFloor;
+        Metrics::Set(m_metrics.m_floor, m_currentFloor);
+        Metrics::Increment(m_metrics.m_floorsTravelled);
+        Mirror();
+        Journal::Record(Journal::EventType::FloorReached, m_index, m_currentFloor);
       }
 
-    } while (m_currentFloor != requestedFloor && !m_shutdownRequested);
+    } while (m_currentFloor != requestedFloor && !m_shutdownRequested && !(parking && m_floors.HasStops())
+      && GetFault() != ElevatorFault::OutOfService);
 
     const std::string message = "Arrived on the floor " + std::to_string(m_currentFloor);
     m_log.Trace(message);
+
+    if (m_currentFloor == Floors::Lobby && m_roundTripStarted)
+    {
+      ++m_statistics.m_roundTrips;
+      m_statistics.m_roundTripsMilliseconds += std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_lobbyDepartureTime).count();
+      m_roundTripStarted = false;
+    }
+  }
+
+  if (parking)
+  {
+    SetStatus(ElevatorStatus::Idle);
+  }
+  else
+    Stop();
+}
+
+/**
+ * \brief Publish the current direction in the metrics and, if changed, in the journal.
+ */
+void Elevator::PublishDirection()
+{
+  const auto direction = static_cast<std::int64_t>(m_currentDirection);
+
+  if (m_metrics.m_direction.load(std::memory_order_relaxed) != direction)
+    Journal::Record(Journal::EventType::DirectionChanged, m_index, m_currentFloor, 0, static_cast<int>(direction));
+
+  Metrics::Set(m_metrics.m_direction, direction);
+  Mirror();
+}
+
+void Elevator::SetTable(ElevatorTable* table)
+{
+  m_table = table;
+  Mirror();
+}
+
+/**
+ * \brief Change the status, accounting the time spent in the previous one.
+ */
+void Elevator::SetStatus(const ElevatorStatus status)
+{
+  if (status != m_status)
+  {
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    const auto since = m_statusSince.exchange(now, std::memory_order_relaxed);
+
+    Metrics::Increment(m_metrics.m_stateMilliseconds[static_cast<int>(m_status) + 1], static_cast<std::uint64_t>(now - since));
   }
 
-  m_floors.ClearStop(m_currentFloor, m_currentDirection);
-  Stop();
+  m_status = status;
+  Metrics::Set(m_metrics.m_status, static_cast<std::int64_t>(m_status));
+  Mirror();
+}
+
+/**
+ * \brief Copy the state used by the dispatcher to the lane of the elevator in the table.
+ */
+void Elevator::Mirror()
+{
+  if (m_table != nullptr)
+    m_table->Set(m_index, m_currentFloor, m_currentDirection, m_status, m_load, m_lowestFloor, m_highestFloor);
+}
+
+std::array<std::chrono::milliseconds, Metrics::NumberOfStates> Elevator::GetStateTimes() const
+{
+  std::array<std::chrono::milliseconds, Metrics::NumberOfStates> times;
+
+  for (unsigned int state = 0; state < Metrics::NumberOfStates; ++state)
+    times[state] = std::chrono::milliseconds(m_metrics.m_stateMilliseconds[state].load(std::memory_order_relaxed));
+
+  // The current status, since the last change
+  const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  const auto state = m_metrics.m_status.load(std::memory_order_relaxed) + 1;
+
+  if (state >= 0 && state < static_cast<std::int64_t>(Metrics::NumberOfStates))
+    times[state] += std::chrono::milliseconds(now - m_statusSince.load(std::memory_order_relaxed));
+
+  return times;
+}
+
+/**
+ * \brief Add the time elapsed since the passed instant to the busy time metric.
+ * \param since Start of the busy period, moved forward to now.
+ */
+void Elevator::AddBusyTime(std::chrono::steady_clock::time_point& since)
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto busyTime = std::chrono::duration_cast<std::chrono::milliseconds>(now - since);
+
+  // Only the whole milliseconds are counted: the remainder is carried to the next period
+  Metrics::Increment(m_metrics.m_busyMilliseconds, static_cast<std::uint64_t>(busyTime.count()));
+  since += busyTime;
 }
 
 void Elevator::ShutDown()
@@ -218,8 +510,12 @@ void Elevator::ShutDown()
 
   Watchdog watchdog(m_name, 20s, callback);
 
-  m_shutdownRequested = true;
-  m_go.notify_one();
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+    m_shutdownRequested = true;
+  }
+
+  m_go.notify_all();
 
   if (m_thread->joinable())
     m_thread->join();
@@ -231,34 +527,268 @@ void Elevator::ShutDown()
   m_log.Trace("Shutdown completed", Log::TraceLevel::Verbose);
 }
 
-void Elevator::SetId(std::string id)
+void Elevator::InjectFault(const ElevatorFault fault)
 {
-  m_elevatorId = std::move(id);
-  m_name = "Elevator " + m_elevatorId;
+  using namespace Configuration::Faults;
 
-  m_people.SetId(m_name);
-  m_floors.SetId(m_name);
-  m_log.SetTraceId(m_name);
+  const auto now = std::chrono::steady_clock::now();
+  auto duration = SlowTime;
+
+  if (fault == ElevatorFault::OutOfService)
+    duration = OutOfServiceTime;
+  else if (fault == ElevatorFault::StuckDoors)
+    duration = StuckDoorsTime;
+
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+    m_fault = fault;
+    m_faultTime = now;
+    m_faultEnd = now + duration;
+  }
+
+  m_log.Trace("Fault injected: " + FaultName(fault) + " for " + std::to_string(duration.count()) + "ms", Log::TraceLevel::Warning);
+  m_go.notify_all();
 }
 
-bool Elevator::Available(const std::shared_ptr<Call>& call) const
+std::chrono::steady_clock::time_point Elevator::GetFaultTime()
 {
-  if (!call->IsValid())
-    return false;
+  std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+  return m_faultTime;
+}
+
+/**
+ * \brief Current fault: an expired fault is cleared.
+ */
+ElevatorFault Elevator::GetFault()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+
+  if (m_fault != ElevatorFault::None && std::chrono::steady_clock::now() >= m_faultEnd)
+    m_fault = ElevatorFault::None;
+
+  return m_fault;
+}
+
+void Elevator::ReleaseCalls(std::vector<std::shared_ptr<Call>>& calls)
+{
+  // Unassigned first: from now on nobody enters this elevator
+  Floors::GetPeople().Unassign(m_elevatorId, calls);
+  m_floors.Clear(false);
+}
+
+/**
+ * \brief Stop serving: the people inside leave on the current floor and all the calls are handed
+ * to the other elevators. Returns when repaired. A pause is possible while out of service.
+ */
+void Elevator::GoOutOfService()
+{
+  m_log.Trace("OUT OF SERVICE on floor " + std::to_string(m_currentFloor), Log::TraceLevel::Warning);
+  Metrics::Increment(m_metrics.m_failures);
+
+  std::list<std::shared_ptr<Call>> exited;
+  std::vector<std::shared_ptr<Call>> evacuated;
+
+  if (!m_people.Empty())
+  {
+    OpenDoors();
+    m_people.Evacuate(m_currentFloor, exited, evacuated);
+  }
+
+  m_load = 0;
+  Metrics::Set(m_metrics.m_load, m_load);
+  Mirror();
+
+  for (const auto& person : exited)
+    Journal::Record(Journal::EventType::PersonAlighted, m_index, m_currentFloor, person->GetId());
+
+  for (const auto& person : evacuated)
+    Journal::Record(Journal::EventType::PersonAlighted, m_index, m_currentFloor, person->GetId());
+
+  Deliver(exited);
+  m_floors.Clear(true);
+
+  if (!evacuated.empty())
+    Floors::GetPeople().Insert(evacuated);
+
+  SetStatus(ElevatorStatus::OutOfOrder);
 
-  if (m_status == ElevatorStatus::OutOfOrder)
+  if (m_failureFunction)
+    m_failureFunction(*this, evacuated);
+
+  {
+    InstrumentedMutex::UniqueLock lock(m_goMutex);
+
+    while (!m_shutdownRequested && m_fault == ElevatorFault::OutOfService && std::chrono::steady_clock::now() < m_faultEnd)
+    {
+      // Nothing moves while out of service: a consistent state for a checkpoint
+      m_paused = m_pauseRequested;
+      m_go.notify_all();
+      m_go.wait_until(lock, m_faultEnd);
+    }
+
+    m_paused = false;
+
+    if (m_fault == ElevatorFault::OutOfService)
+      m_fault = ElevatorFault::None;
+  }
+
+  SetStatus(ElevatorStatus::Idle);
+
+  m_log.Trace("Back in service", Log::TraceLevel::Warning);
+}
+
+/**
+ * \brief Block the doors operation while the doors are stuck. Beyond the failover timeout the
+ * elevator is out of order and the floor calls are handed to the other elevators.
+ */
+void Elevator::WaitWhileDoorsStuck()
+{
+  if (GetFault() != ElevatorFault::StuckDoors)
+    return;
+
+  m_log.Trace("Doors stuck", Log::TraceLevel::Warning);
+
+  InstrumentedMutex::UniqueLock lock(m_goMutex);
+  const auto stuck = [this]() { return !m_shutdownRequested && m_fault == ElevatorFault::StuckDoors && std::chrono::steady_clock::now() < m_faultEnd; };
+  const auto failoverTime = m_faultTime + Configuration::Faults::FailoverTimeout;
+
+  while (stuck() && std::chrono::steady_clock::now() < failoverTime)
+    m_go.wait_until(lock, std::min(failoverTime, m_faultEnd));
+
+  if (stuck())
+  {
+    lock.unlock();
+
+    const auto previousStatus = m_status;
+    SetStatus(ElevatorStatus::OutOfOrder);
+    Metrics::Increment(m_metrics.m_failures);
+
+    std::vector<std::shared_ptr<Call>> calls;
+
+    if (m_failureFunction)
+      m_failureFunction(*this, calls);
+
+    lock.lock();
+
+    while (stuck())
+      m_go.wait_until(lock, m_faultEnd);
+
+    SetStatus(previousStatus);
+  }
+
+  if (m_fault == ElevatorFault::StuckDoors)
+    m_fault = ElevatorFault::None;
+
+  m_log.Trace("Doors repaired", Log::TraceLevel::Warning);
+}
+
+void Elevator::Pause()
+{
+  InstrumentedMutex::UniqueLock lock(m_goMutex);
+
+  m_pauseRequested = true;
+  m_go.notify_all();
+
+  m_go.wait(lock, [this]() { return m_paused || m_shutdownRequested; });
+}
+
+void Elevator::Resume()
+{
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_goMutex);
+    m_pauseRequested = false;
+  }
+
+  m_go.notify_all();
+}
+
+/**
+ * \brief Safe point of the elevator thread: if a pause is requested, wait for the resume.
+ */
+void Elevator::WaitWhilePaused()
+{
+  InstrumentedMutex::UniqueLock lock(m_goMutex);
+
+  if (!m_pauseRequested)
+    return;
+
+  m_paused = true;
+  m_go.notify_all();
+
+  m_go.wait(lock, [this]() { return !m_pauseRequested || m_shutdownRequested; });
+  m_paused = false;
+}
+
+void Elevator::Serialize(CheckpointWriter& writer)
+{
+  writer.Write(m_currentFloor);
+  writer.Write(m_currentDirection);
+  writer.Write(m_status);
+  writer.Write(m_doorsStatus);
+  writer.Write(m_parked);
+  writer.Write(m_homeFloor);
+
+  writer.Write(m_statistics.m_peopleDelivered.load());
+  writer.Write(m_statistics.m_roundTrips.load());
+  writer.Write(m_statistics.m_roundTripsMilliseconds.load());
+  writer.Write(m_lobbyDepartureTime);
+  writer.Write(m_roundTripStarted);
+
+  m_floors.Serialize(writer);
+  m_people.Serialize(writer);
+}
+
+bool Elevator::Deserialize(CheckpointReader& reader)
+{
+  unsigned int peopleDelivered = 0;
+  unsigned int roundTrips = 0;
+  std::int64_t roundTripsTime = 0;
+
+  const auto good = reader.Read(m_currentFloor) && reader.Read(m_currentDirection) && reader.Read(m_status) && reader.Read(m_doorsStatus)
+    && reader.Read(m_parked) && reader.Read(m_homeFloor)
+    && reader.Read(peopleDelivered) && reader.Read(roundTrips) && reader.Read(roundTripsTime)
+    && reader.Read(m_lobbyDepartureTime) && reader.Read(m_roundTripStarted)
+    && m_floors.Deserialize(reader) && m_people.Deserialize(reader);
+
+  if (!good || !Floors::IsValid(m_currentFloor))
     return false;
 
-  if (m_status == ElevatorStatus::Idle || m_currentDirection == Direction::None)
-    return true;
+  m_statistics.m_peopleDelivered = peopleDelivered;
+  m_statistics.m_roundTrips = roundTrips;
+  m_statistics.m_roundTripsMilliseconds = roundTripsTime;
+  m_load = static_cast<unsigned int>(m_people.Size());
 
-  if (call->GetDirection() == m_currentDirection && m_currentDirection == Direction::Up && call->GetStartFloor() > m_currentFloor)
-    return true;
+  // The faults are not part of the checkpoint
+  if (m_status == ElevatorStatus::OutOfOrder && GetFault() != ElevatorFault::OutOfService)
+    m_status = ElevatorStatus::Idle;
 
-  if (call->GetDirection() == m_currentDirection && m_currentDirection == Direction::Down && call->GetStartFloor() < m_currentFloor)
-    return true;
+  Metrics::Set(m_metrics.m_floor, m_currentFloor);
+  Metrics::Set(m_metrics.m_direction, static_cast<std::int64_t>(m_currentDirection));
+  Metrics::Set(m_metrics.m_status, static_cast<std::int64_t>(m_status));
+  Metrics::Set(m_metrics.m_load, m_load);
+  Mirror();
 
-  return false;
+  m_log.Trace("Restored on floor " + std::to_string(m_currentFloor) + " with " + std::to_string(m_load) + " people inside");
+  m_floors.Trace(m_currentFloor);
+
+  return true;
 }
 
+void Elevator::SetId(std::string id)
+{
+  m_elevatorId = std::move(id);
+  m_name = "Elevator " + m_elevatorId;
 
+  m_people.SetId(m_name);
+  m_floors.SetId(m_name);
+  m_log.SetTraceId(m_name);
+}
+
+void Elevator::SetZone(const Floors::FloorNumber lowestFloor, const Floors::FloorNumber highestFloor)
+{
+  m_lowestFloor = lowestFloor;
+  m_highestFloor = highestFloor;
+  Mirror();
+
+  m_log.Trace("Zone: floors " + std::to_string(m_lowestFloor) + "-" + std::to_string(m_highestFloor) + " and lobby");
+}
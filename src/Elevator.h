@@ -8,14 +8,19 @@
 #pragma once
 
 #include <thread>
-#include <mutex>
 #include <chrono>
 #include <string>
 #include <atomic>
-#include <condition_variable>
+#include <functional>
+#include <list>
+#include <vector>
+#include <array>
 
 #include "Floors.h"
 #include "People.h"
+#include "Configuration.h"
+#include "Metrics.h"
+#include "LockStats.h"
 
 using namespace std::chrono_literals;
 
@@ -33,11 +38,52 @@ enum class DoorsStatus
   Closed
 };
 
+enum class ElevatorFault
+{
+  None,
+  OutOfService,  // stops on the next floor, the people inside leave, out of order until repaired
+  StuckDoors,    // the next doors operation blocks until repaired
+  Slow,          // the travel times are multiplied by Configuration::Faults::SlowFactor
+};
+
 
 class Elevator final
 {
 public:
-  explicit Elevator(const std::string& id = "");
+  /**
+   * \brief Function called for every person exited on a transfer floor, to continue the journey.
+   */
+  typedef std::function<void(const std::shared_ptr<Call>& call)> TransferFunction;
+
+  /**
+   * \brief Function called when the elevator is idle, returns the floor where to park.
+   */
+  typedef std::function<Floors::FloorNumber(const Elevator& elevator)> ParkingFunction;
+
+  /**
+   * \brief Function called when the elevator fails, with the people evacuated: the calls of the elevator
+   * (see ReleaseCalls) and the people must be assigned to the other elevators.
+   */
+  typedef std::function<void(Elevator& elevator, std::vector<std::shared_ptr<Call>>& calls)> FailureFunction;
+
+  /**
+   * \brief Function called, without locks held, when the elevator can take new calls:
+   * when it becomes idle and when it starts a run, possibly in a new direction.
+   */
+  typedef std::function<void(const Elevator& elevator)> AvailableFunction;
+
+  /**
+   * \brief Performance counters, written by the elevator thread and read by the periodic report.
+   */
+  struct Statistics
+  {
+    std::atomic<unsigned int> m_peopleDelivered{ 0 };
+    std::atomic<unsigned int> m_roundTrips{ 0 };                // lobby to lobby trips
+    std::atomic<std::int64_t> m_roundTripsMilliseconds{ 0 };    // total time of the round trips
+  };
+
+public:
+  explicit Elevator(const std::string& id = "", const unsigned int index = 0);
 
   Elevator(const Elevator&) = delete;
   Elevator(Elevator&&) = delete;
@@ -48,29 +94,112 @@ public:
   Elevator& operator=(Elevator&& other) noexcept = delete;
 
 public:
-  bool Available(const std::shared_ptr<Call>& call) const;
   bool AnswerToCall(const std::shared_ptr<Call>& call);
 
+  /**
+   * \brief Remove the stop of a call assigned to the elevator and not served yet, moved to another elevator.
+   */
+  void WithdrawCall(const std::shared_ptr<Call>& call);
+
   void ShutDown();
 
   void SetId(std::string id);
   std::string GetId() const { return m_elevatorId; }
 
   std::string GetElevatorName() const { return m_name; }
+  unsigned int GetIndex() const { return m_index; }
 
   Floors::FloorNumber GetCurrentFloor() const { return m_currentFloor; }
   ElevatorStatus GetStatus() const { return m_status; }
   Direction GetDirection() const { return m_currentDirection; }
 
+  void SetZone(const Floors::FloorNumber lowestFloor, const Floors::FloorNumber highestFloor);
+  bool Serves(const Floors::FloorNumber floor) const { return floor == Floors::Lobby || (floor >= m_lowestFloor && floor <= m_highestFloor); }
+  bool Serves(const std::shared_ptr<Call>& call) const { return Serves(call->GetStartFloor()) && Serves(call->GetDestinationFloor()); }
+
+  Floors::FloorNumber GetLowestFloor() const { return m_lowestFloor; }
+  Floors::FloorNumber GetHighestFloor() const { return m_highestFloor; }
+
+  void SetTransferFunction(TransferFunction transferFunction) { m_transferFunction = std::move(transferFunction); }
+  void SetParkingFunction(ParkingFunction parkingFunction) { m_parkingFunction = std::move(parkingFunction); }
+  void SetFailureFunction(FailureFunction failureFunction) { m_failureFunction = std::move(failureFunction); }
+
+  /**
+   * \brief Set the table where the elevator mirrors its state, see ElevatorTable.
+   */
+  void SetTable(class ElevatorTable* table);
+  void SetAvailableFunction(AvailableFunction availableFunction) { m_availableFunction = std::move(availableFunction); }
+
+  /**
+   * \brief Start the elevator thread. The functions, the table and the zone must be set before: the thread reads them unlocked.
+   */
+  void Start();
+
+  /**
+   * \brief Inject a fault, lasting the time in Configuration::Faults. Replaces the current fault, if any.
+   */
+  void InjectFault(const ElevatorFault fault);
+
+  /**
+   * \brief Time of the last injected fault.
+   */
+  std::chrono::steady_clock::time_point GetFaultTime();
+
+  /**
+   * \brief Take back the floor calls assigned to the elevator. Called by the failure function.
+   * \param calls [Output] Calls to assign again.
+   */
+  void ReleaseCalls(std::vector<std::shared_ptr<Call>>& calls);
+
+  void SetHomeFloor(const Floors::FloorNumber homeFloor) { m_homeFloor = homeFloor; }
+  Floors::FloorNumber GetHomeFloor() const { return m_homeFloor; }
+
+  const Statistics& GetStatistics() const { return m_statistics; }
+
+  /**
+   * \brief Time spent in every status (index: status + 1), the current one included. Thread safe.
+   */
+  std::array<std::chrono::milliseconds, Metrics::NumberOfStates> GetStateTimes() const;
+
+  unsigned int GetLoad() const { return m_load; }
+  bool IsFull() const { return m_load >= Configuration::Elevator::Capacity; }
+
+  /**
+   * \brief Stop the elevator on the next consistent state: idle or stopped on a floor after
+   * people entered and exited. Returns when the elevator is paused.
+   */
+  void Pause();
+  void Resume();
+
+  /**
+   * \brief Write and read the elevator state, stops and people inside. The elevator must be paused.
+   */
+  void Serialize(class CheckpointWriter& writer);
+  bool Deserialize(class CheckpointReader& reader);
+
 private:
   bool OpenDoors();
   bool CloseDoors();
 
   void PeopleEnterAndExit();
-  void Move(Floors::FloorNumber requestedFloor);
+  void Move(Floors::FloorNumber requestedFloor, const bool parking = false);
   void Stop();
+  void Park();
+
+  Floors::FloorNumber GetNextStop();
+
+  void Deliver(const std::list<std::shared_ptr<Call>>& exited);
+
+  ElevatorFault GetFault();
+  void GoOutOfService();
+  void WaitWhileDoorsStuck();
 
-  void RestoreDestinationStops();
+  void AddBusyTime(std::chrono::steady_clock::time_point& since);
+  void PublishDirection();
+  void SetStatus(const ElevatorStatus status);
+  void Mirror();
+
+  void WaitWhilePaused();
 
 private:
   void ElevatorThreadFunction();
@@ -80,22 +209,51 @@ private:
   Floors m_floors;
 
   People m_people;
+  std::atomic_uint m_load{ 0 };
 
   ElevatorStatus m_status = ElevatorStatus::Idle;
+  std::atomic<std::int64_t> m_statusSince{ 0 };  // milliseconds of the steady clock
   Direction m_currentDirection = Direction::None;
+  std::atomic<Direction> m_requestedDirection{ Direction::None };  // of the first call assigned while idle, taken by the elevator thread
 
   DoorsStatus m_doorsStatus = DoorsStatus::Closed;
 
-  std::condition_variable m_go;
-  std::mutex m_goMutex;
+  InstrumentedMutex::ConditionVariable m_go;
+  InstrumentedMutex m_goMutex{ "Elevator go" };
+
+  Floors::FloorNumber m_lowestFloor = Floors::BottomFloor;
+  Floors::FloorNumber m_highestFloor = Floors::TopFloor;
+
+  TransferFunction m_transferFunction;
+  ParkingFunction m_parkingFunction;
+  FailureFunction m_failureFunction;
+  AvailableFunction m_availableFunction;
+  class ElevatorTable* m_table = nullptr;
+
+  ElevatorFault m_fault = ElevatorFault::None;  // protected by m_goMutex, as the fault times
+  std::chrono::steady_clock::time_point m_faultTime;
+  std::chrono::steady_clock::time_point m_faultEnd;
+
+  Floors::FloorNumber m_homeFloor = Floors::Lobby;
+  bool m_parked = false;
+
+  Statistics m_statistics;
+  std::chrono::steady_clock::time_point m_lobbyDepartureTime;
+  bool m_roundTripStarted = false;
 
   std::string m_elevatorId = "?";
   std::string m_name;
 
+  unsigned int m_index = 0;
+  Metrics::ElevatorMetrics& m_metrics;
+
   std::unique_ptr<std::thread> m_thread;
   std::atomic_bool m_shutdownRequested{ false };
   std::atomic_bool m_working{ false };
 
+  std::atomic_bool m_pauseRequested{ false };
+  bool m_paused = false; // protected by m_goMutex
+
   Log m_log;
 };
 
@@ -0,0 +1,408 @@
+#include "ElevatorTable.h"
+
+#include "TravelTimes.h"
+#include "Configuration.h"
+
+#include <limits>
+
+#if defined(ELEVATOR_TABLE_AVX2)
+#include <immintrin.h>
+#elif defined(ELEVATOR_TABLE_SSE2)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  constexpr std::size_t LaneBlock = 8;
+  constexpr std::int32_t NotAvailable = std::numeric_limits<std::int32_t>::max();
+
+  /**
+   * \brief Reduce the lanes of a vector kernel: lowest time, then lowest index.
+   */
+  int Reduce(const std::int32_t* times, const std::int32_t* indexes, const std::size_t lanes)
+  {
+    auto bestTime = NotAvailable;
+    auto bestIndex = -1;
+
+    for (std::size_t lane = 0; lane < lanes; ++lane)
+    {
+      if (times[lane] < bestTime || (times[lane] == bestTime && times[lane] != NotAvailable && indexes[lane] < bestIndex))
+      {
+        bestTime = times[lane];
+        bestIndex = indexes[lane];
+      }
+    }
+
+    return bestIndex;
+  }
+}
+
+ElevatorTable::ElevatorTable(const std::size_t numberOfElevators) :
+  m_size(numberOfElevators), m_lanes(numberOfElevators), m_refreshedSequence(numberOfElevators, 0)
+{
+  const auto lanes = (numberOfElevators + LaneBlock - 1) / LaneBlock * LaneBlock;
+
+  m_floor.assign(lanes, 0);
+  m_direction.assign(lanes, static_cast<std::int32_t>(Direction::None));
+  m_status.assign(lanes, static_cast<std::int32_t>(ElevatorStatus::OutOfOrder));
+  m_load.assign(lanes, 0);
+  m_lowestFloor.assign(lanes, static_cast<std::int32_t>(Floors::BottomFloor));
+  m_highestFloor.assign(lanes, static_cast<std::int32_t>(Floors::TopFloor));
+  m_stopsTime.assign(lanes, 0);
+
+  // Never set lanes read as the padding: never available
+  for (auto& lane : m_lanes)
+  {
+    for (auto& field : lane.m_fields)
+      field.store(0, std::memory_order_relaxed);
+
+    lane.m_fields[DirectionField].store(static_cast<std::int32_t>(Direction::None), std::memory_order_relaxed);
+    lane.m_fields[StatusField].store(static_cast<std::int32_t>(ElevatorStatus::OutOfOrder), std::memory_order_relaxed);
+    lane.m_fields[LowestFloorField].store(static_cast<std::int32_t>(Floors::BottomFloor), std::memory_order_relaxed);
+    lane.m_fields[HighestFloorField].store(static_cast<std::int32_t>(Floors::TopFloor), std::memory_order_relaxed);
+  }
+
+  m_travelTimes.resize(Floors::TotalFloors * Floors::TotalFloors);
+
+  for (Floors::FloorNumber from = Floors::BottomFloor; Floors::IsValid(from); ++from)
+  {
+    for (Floors::FloorNumber to = Floors::BottomFloor; Floors::IsValid(to); ++to)
+      m_travelTimes[to * Floors::TotalFloors + from] = static_cast<std::int32_t>(TravelTimes::Get(from, to).count());
+  }
+}
+
+void ElevatorTable::Set(const unsigned int index, const Floors::FloorNumber floor, const Direction direction, const ElevatorStatus status,
+  const unsigned int load, const Floors::FloorNumber lowestFloor, const Floors::FloorNumber highestFloor)
+{
+  if (index >= m_size)
+    return;
+
+  const auto stopTime = 2 * Configuration::Elevator::DoorsOperationTime + Configuration::Elevator::EnterAndExitTime;
+  auto& lane = m_lanes[index];
+
+  // Odd while writing: the reader retries
+  const auto sequence = lane.m_sequence.load(std::memory_order_relaxed);
+  lane.m_sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  lane.m_fields[FloorField].store(static_cast<std::int32_t>(Floors::IsValid(floor) ? floor : Floors::BottomFloor), std::memory_order_relaxed);
+  lane.m_fields[DirectionField].store(static_cast<std::int32_t>(direction), std::memory_order_relaxed);
+  lane.m_fields[StatusField].store(static_cast<std::int32_t>(status), std::memory_order_relaxed);
+  lane.m_fields[LoadField].store(static_cast<std::int32_t>(load), std::memory_order_relaxed);
+  lane.m_fields[LowestFloorField].store(static_cast<std::int32_t>(lowestFloor), std::memory_order_relaxed);
+  lane.m_fields[HighestFloorField].store(static_cast<std::int32_t>(highestFloor), std::memory_order_relaxed);
+  lane.m_fields[StopsTimeField].store(static_cast<std::int32_t>((load * stopTime).count()), std::memory_order_relaxed);
+
+  lane.m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void ElevatorTable::Refresh()
+{
+  for (std::size_t index = 0; index < m_size; ++index)
+  {
+    const auto& lane = m_lanes[index];
+    std::int32_t fields[NumberOfFields];
+    std::uint32_t sequence;
+
+    do
+    {
+      sequence = lane.m_sequence.load(std::memory_order_acquire);
+
+      if (sequence == m_refreshedSequence[index])
+        break; // unchanged, or copied already
+
+      for (unsigned int field = 0; field < NumberOfFields; ++field)
+        fields[field] = lane.m_fields[field].load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((sequence & 1U) != 0 || lane.m_sequence.load(std::memory_order_relaxed) != sequence);
+
+    if (sequence == m_refreshedSequence[index])
+      continue;
+
+    m_floor[index] = fields[FloorField];
+    m_direction[index] = fields[DirectionField];
+    m_status[index] = fields[StatusField];
+    m_load[index] = fields[LoadField];
+    m_lowestFloor[index] = fields[LowestFloorField];
+    m_highestFloor[index] = fields[HighestFloorField];
+    m_stopsTime[index] = fields[StopsTimeField];
+
+    m_refreshedSequence[index] = sequence;
+  }
+}
+
+ElevatorTable::Query ElevatorTable::GetQuery(const Floors::FloorNumber startFloor, const Floors::FloorNumber destinationFloor) const
+{
+  Query query{ 0, 0, static_cast<std::int32_t>(Direction::None), nullptr };
+
+  if (!Floors::IsValid(startFloor) || !Floors::IsValid(destinationFloor) || startFloor == destinationFloor)
+    return query;
+
+  query.m_startFloor = static_cast<std::int32_t>(startFloor);
+  query.m_destinationFloor = static_cast<std::int32_t>(destinationFloor);
+  query.m_direction = static_cast<std::int32_t>(destinationFloor > startFloor ? Direction::Up : Direction::Down);
+  query.m_travelTimes = &m_travelTimes[startFloor * Floors::TotalFloors];
+
+  return query;
+}
+
+int ElevatorTable::Best(const Query& query)
+{
+  Refresh();
+
+#if defined(ELEVATOR_TABLE_AVX2)
+  return Best(query, Kernel::Avx2);
+#elif defined(ELEVATOR_TABLE_SSE2)
+  return Best(query, Kernel::Sse2);
+#else
+  return Best(query, Kernel::Scalar);
+#endif
+}
+
+int ElevatorTable::Best(const Query& query, const Kernel kernel) const
+{
+  if (query.m_travelTimes == nullptr)
+    return -1;
+
+  switch (kernel)
+  {
+  case Kernel::Avx2:
+    return BestAvx2(query);
+
+  case Kernel::Sse2:
+    return BestSse2(query);
+
+  case Kernel::Scalar:
+  default:
+    return BestScalar(query);
+  }
+}
+
+bool ElevatorTable::IsCompiled(const Kernel kernel)
+{
+  switch (kernel)
+  {
+#if defined(ELEVATOR_TABLE_AVX2)
+  case Kernel::Avx2:
+    return true;
+#endif
+
+#if defined(ELEVATOR_TABLE_SSE2)
+  case Kernel::Sse2:
+    return true;
+#endif
+
+  case Kernel::Scalar:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+const char* ElevatorTable::GetName(const Kernel kernel)
+{
+  switch (kernel)
+  {
+  case Kernel::Avx2:
+    return "AVX2";
+
+  case Kernel::Sse2:
+    return "SSE2";
+
+  case Kernel::Scalar:
+  default:
+    return "scalar";
+  }
+}
+
+int ElevatorTable::BestScalar(const Query& query) const
+{
+  const auto lobby = static_cast<std::int32_t>(Floors::Lobby);
+  const auto capacity = static_cast<std::int32_t>(Configuration::Elevator::Capacity);
+  const auto up = query.m_direction == static_cast<std::int32_t>(Direction::Up);
+
+  auto bestTime = NotAvailable;
+  auto bestIndex = -1;
+
+  for (std::size_t index = 0; index < m_size; ++index)
+  {
+    const auto serves = [this, index, lobby](const std::int32_t floor)
+      { return floor == lobby || (floor >= m_lowestFloor[index] && floor <= m_highestFloor[index]); };
+
+    if (!serves(query.m_startFloor) || !serves(query.m_destinationFloor))
+      continue;
+
+    if (m_status[index] == static_cast<std::int32_t>(ElevatorStatus::OutOfOrder) || m_load[index] >= capacity)
+      continue;
+
+    const auto ahead = m_direction[index] == query.m_direction
+      && (up ? query.m_startFloor > m_floor[index] : query.m_startFloor < m_floor[index]);
+
+    if (m_status[index] != static_cast<std::int32_t>(ElevatorStatus::Idle) && m_direction[index] != static_cast<std::int32_t>(Direction::None) && !ahead)
+      continue;
+
+    const auto time = query.m_travelTimes[m_floor[index]] + m_stopsTime[index];
+
+    if (time < bestTime)
+    {
+      bestTime = time;
+      bestIndex = static_cast<int>(index);
+    }
+  }
+
+  return bestIndex;
+}
+
+#if defined(ELEVATOR_TABLE_SSE2)
+
+int ElevatorTable::BestSse2(const Query& query) const
+{
+  const auto lobby = static_cast<std::int32_t>(Floors::Lobby);
+  const auto up = query.m_direction == static_cast<std::int32_t>(Direction::Up);
+
+  const auto allOnes = _mm_set1_epi32(-1);
+  const auto startFloor = _mm_set1_epi32(query.m_startFloor);
+  const auto destinationFloor = _mm_set1_epi32(query.m_destinationFloor);
+  const auto callDirection = _mm_set1_epi32(query.m_direction);
+  const auto startInLobby = _mm_set1_epi32(query.m_startFloor == lobby ? -1 : 0);
+  const auto destinationInLobby = _mm_set1_epi32(query.m_destinationFloor == lobby ? -1 : 0);
+  const auto capacity = _mm_set1_epi32(static_cast<std::int32_t>(Configuration::Elevator::Capacity));
+  const auto idle = _mm_set1_epi32(static_cast<std::int32_t>(ElevatorStatus::Idle));
+  const auto outOfOrder = _mm_set1_epi32(static_cast<std::int32_t>(ElevatorStatus::OutOfOrder));
+  const auto none = _mm_set1_epi32(static_cast<std::int32_t>(Direction::None));
+  const auto notAvailable = _mm_set1_epi32(NotAvailable);
+  const auto step = _mm_set1_epi32(4);
+
+  auto bestTime = notAvailable;
+  auto bestIndex = _mm_set1_epi32(-1);
+  auto index = _mm_setr_epi32(0, 1, 2, 3);
+
+  // SSE2 has no blend: (mask & a) | (~mask & b)
+  const auto select = [](const __m128i mask, const __m128i a, const __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); };
+
+  for (std::size_t lane = 0; lane < m_size; lane += 4)
+  {
+    const auto floor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_floor[lane]));
+    const auto direction = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_direction[lane]));
+    const auto status = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_status[lane]));
+    const auto load = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_load[lane]));
+    const auto lowestFloor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_lowestFloor[lane]));
+    const auto highestFloor = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_highestFloor[lane]));
+
+    const auto servesStart = _mm_or_si128(startInLobby,
+      _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(lowestFloor, startFloor), _mm_cmpgt_epi32(startFloor, highestFloor)), allOnes));
+    const auto servesDestination = _mm_or_si128(destinationInLobby,
+      _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(lowestFloor, destinationFloor), _mm_cmpgt_epi32(destinationFloor, highestFloor)), allOnes));
+
+    const auto ahead = _mm_and_si128(_mm_cmpeq_epi32(direction, callDirection),
+      up ? _mm_cmpgt_epi32(startFloor, floor) : _mm_cmpgt_epi32(floor, startFloor));
+    const auto idleOrAhead = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(status, idle), _mm_cmpeq_epi32(direction, none)), ahead);
+
+    auto available = _mm_and_si128(servesStart, servesDestination);
+    available = _mm_andnot_si128(_mm_cmpeq_epi32(status, outOfOrder), available);
+    available = _mm_and_si128(available, _mm_cmpgt_epi32(capacity, load));
+    available = _mm_and_si128(available, idleOrAhead);
+
+    // No gather in SSE2
+    const auto travelTime = _mm_setr_epi32(query.m_travelTimes[m_floor[lane]], query.m_travelTimes[m_floor[lane + 1]],
+      query.m_travelTimes[m_floor[lane + 2]], query.m_travelTimes[m_floor[lane + 3]]);
+    const auto time = select(available, _mm_add_epi32(travelTime, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_stopsTime[lane]))), notAvailable);
+
+    const auto better = _mm_cmplt_epi32(time, bestTime);
+    bestTime = select(better, time, bestTime);
+    bestIndex = select(better, index, bestIndex);
+    index = _mm_add_epi32(index, step);
+  }
+
+  std::int32_t times[4];
+  std::int32_t indexes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(times), bestTime);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(indexes), bestIndex);
+
+  return Reduce(times, indexes, 4);
+}
+
+#else
+
+int ElevatorTable::BestSse2(const Query& query) const
+{
+  return BestScalar(query);
+}
+
+#endif
+
+#if defined(ELEVATOR_TABLE_AVX2)
+
+int ElevatorTable::BestAvx2(const Query& query) const
+{
+  const auto lobby = static_cast<std::int32_t>(Floors::Lobby);
+  const auto up = query.m_direction == static_cast<std::int32_t>(Direction::Up);
+
+  const auto allOnes = _mm256_set1_epi32(-1);
+  const auto startFloor = _mm256_set1_epi32(query.m_startFloor);
+  const auto destinationFloor = _mm256_set1_epi32(query.m_destinationFloor);
+  const auto callDirection = _mm256_set1_epi32(query.m_direction);
+  const auto startInLobby = _mm256_set1_epi32(query.m_startFloor == lobby ? -1 : 0);
+  const auto destinationInLobby = _mm256_set1_epi32(query.m_destinationFloor == lobby ? -1 : 0);
+  const auto capacity = _mm256_set1_epi32(static_cast<std::int32_t>(Configuration::Elevator::Capacity));
+  const auto idle = _mm256_set1_epi32(static_cast<std::int32_t>(ElevatorStatus::Idle));
+  const auto outOfOrder = _mm256_set1_epi32(static_cast<std::int32_t>(ElevatorStatus::OutOfOrder));
+  const auto none = _mm256_set1_epi32(static_cast<std::int32_t>(Direction::None));
+  const auto notAvailable = _mm256_set1_epi32(NotAvailable);
+  const auto step = _mm256_set1_epi32(8);
+
+  auto bestTime = notAvailable;
+  auto bestIndex = _mm256_set1_epi32(-1);
+  auto index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for (std::size_t lane = 0; lane < m_size; lane += 8)
+  {
+    const auto floor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_floor[lane]));
+    const auto direction = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_direction[lane]));
+    const auto status = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_status[lane]));
+    const auto load = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_load[lane]));
+    const auto lowestFloor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_lowestFloor[lane]));
+    const auto highestFloor = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_highestFloor[lane]));
+
+    const auto servesStart = _mm256_or_si256(startInLobby,
+      _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(lowestFloor, startFloor), _mm256_cmpgt_epi32(startFloor, highestFloor)), allOnes));
+    const auto servesDestination = _mm256_or_si256(destinationInLobby,
+      _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(lowestFloor, destinationFloor), _mm256_cmpgt_epi32(destinationFloor, highestFloor)), allOnes));
+
+    const auto ahead = _mm256_and_si256(_mm256_cmpeq_epi32(direction, callDirection),
+      up ? _mm256_cmpgt_epi32(startFloor, floor) : _mm256_cmpgt_epi32(floor, startFloor));
+    const auto idleOrAhead = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi32(status, idle), _mm256_cmpeq_epi32(direction, none)), ahead);
+
+    auto available = _mm256_and_si256(servesStart, servesDestination);
+    available = _mm256_andnot_si256(_mm256_cmpeq_epi32(status, outOfOrder), available);
+    available = _mm256_and_si256(available, _mm256_cmpgt_epi32(capacity, load));
+    available = _mm256_and_si256(available, idleOrAhead);
+
+    const auto travelTime = _mm256_i32gather_epi32(query.m_travelTimes, floor, 4);
+    const auto time = _mm256_blendv_epi8(notAvailable,
+      _mm256_add_epi32(travelTime, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_stopsTime[lane]))), available);
+
+    const auto better = _mm256_cmpgt_epi32(bestTime, time);
+    bestTime = _mm256_blendv_epi8(bestTime, time, better);
+    bestIndex = _mm256_blendv_epi8(bestIndex, index, better);
+    index = _mm256_add_epi32(index, step);
+  }
+
+  std::int32_t times[8];
+  std::int32_t indexes[8];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(times), bestTime);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(indexes), bestIndex);
+
+  return Reduce(times, indexes, 8);
+}
+
+#else
+
+int ElevatorTable::BestAvx2(const Query& query) const
+{
+  return BestSse2(query);
+}
+
+#endif
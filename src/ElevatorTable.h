@@ -0,0 +1,132 @@
+/**********************************************************************************
+*        File: ElevatorTable.h
+* Description: Structure of arrays mirror of the elevators state, with vectorized
+*              evaluation of the elevators for a call.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The AVX2 kernel is compiled only with AVX2 enabled (make AVX2=1,
+*              /arch:AVX2), the SSE2 one on every x86-64 target.
+**********************************************************************************/
+
+#pragma once
+
+#include "Elevator.h"
+#include "Floors.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__)
+#define ELEVATOR_TABLE_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define ELEVATOR_TABLE_SSE2
+#endif
+
+/**
+ * \brief One lane per elevator: floor, direction, status, load, zone and the time of the stops for the people inside.
+ *
+ * Every lane has a single writer, the thread of its elevator (or whoever holds the elevator paused or
+ * not started yet), and is published with a sequence counter. The dispatcher, one at a time with the
+ * management lock held, copies the lanes changed since its last evaluation to the arrays read by the
+ * kernels, retrying a lane being written: it never sees the fields of two different updates.
+ * The arrays are padded to a multiple of 8 with elevators that are never available.
+ */
+class ElevatorTable final
+{
+public:
+  enum class Kernel
+  {
+    Scalar,
+    Sse2,
+    Avx2,
+  };
+
+  /**
+   * \brief Call to evaluate: floors, direction and the travel times from its start floor.
+   */
+  struct Query
+  {
+    std::int32_t m_startFloor;
+    std::int32_t m_destinationFloor;
+    std::int32_t m_direction;
+    const std::int32_t* m_travelTimes;  // milliseconds from the start floor to every floor
+  };
+
+public:
+  explicit ElevatorTable(const std::size_t numberOfElevators);
+
+  ElevatorTable(const ElevatorTable&) = delete;
+  ElevatorTable(ElevatorTable&&) = delete;
+
+  ElevatorTable& operator=(const ElevatorTable&) = delete;
+  ElevatorTable& operator=(ElevatorTable&&) = delete;
+
+public:
+  /**
+   * \brief Publish the state of an elevator. Only one thread at a time writes a lane.
+   */
+  void Set(const unsigned int index, const Floors::FloorNumber floor, const Direction direction, const ElevatorStatus status,
+    const unsigned int load, const Floors::FloorNumber lowestFloor, const Floors::FloorNumber highestFloor);
+
+  std::size_t Size() const { return m_size; }
+
+  Query GetQuery(const Floors::FloorNumber startFloor, const Floors::FloorNumber destinationFloor) const;
+
+  /**
+   * \brief Copy the lanes published since the last refresh to the arrays evaluated by the kernels.
+   */
+  void Refresh();
+
+  /**
+   * \brief Refresh, then the available elevator with the lowest estimated time (travel time to the start floor
+   * plus a stop for every person inside, as Management::EstimatedTime); on equal times the lowest index.
+   * An elevator is available if its zone (or the lobby) holds both floors, it is not out of order nor full,
+   * and it is idle, without a direction, or going in the direction of the call with the start floor ahead.
+   * \return Index of the elevator, -1 if none is available or the call is not valid.
+   */
+  int Best(const Floors::FloorNumber startFloor, const Floors::FloorNumber destinationFloor) { return Best(GetQuery(startFloor, destinationFloor)); }
+  int Best(const Query& query);
+
+  /**
+   * \brief Evaluate the arrays as of the last refresh with a given kernel; Best uses the fastest one compiled.
+   */
+  int Best(const Query& query, const Kernel kernel) const;
+
+  static bool IsCompiled(const Kernel kernel);
+  static const char* GetName(const Kernel kernel);
+
+private:
+  int BestScalar(const Query& query) const;
+  int BestSse2(const Query& query) const;
+  int BestAvx2(const Query& query) const;
+
+private:
+  enum Field : unsigned int { FloorField, DirectionField, StatusField, LoadField, LowestFloorField, HighestFloorField, StopsTimeField, NumberOfFields };
+
+  /**
+   * \brief State published by an elevator: the sequence is odd while the fields are being written.
+   */
+  struct Lane
+  {
+    std::atomic<std::uint32_t> m_sequence{ 0 };
+    std::atomic<std::int32_t> m_fields[NumberOfFields];
+  };
+
+private:
+  std::size_t m_size = 0;
+
+  std::vector<Lane> m_lanes;
+  std::vector<std::uint32_t> m_refreshedSequence;  // sequence of every lane at the last refresh
+
+  std::vector<std::int32_t> m_floor;
+  std::vector<std::int32_t> m_direction;
+  std::vector<std::int32_t> m_status;
+  std::vector<std::int32_t> m_load;
+  std::vector<std::int32_t> m_lowestFloor;
+  std::vector<std::int32_t> m_highestFloor;
+  std::vector<std::int32_t> m_stopsTime;  // milliseconds, a stop for every person inside
+
+  std::vector<std::int32_t> m_travelTimes;  // milliseconds, row of the start floor, column of the elevator floor
+};
@@ -0,0 +1,183 @@
+/**********************************************************************************
+*        File: ElevatorTableBenchmark.cpp
+* Description: Benchmark of the evaluation of the elevators for a call: the sort and scan
+*              of the elevator objects and the ElevatorTable kernels, 32 to 256 elevators.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: make benchmark (make benchmark AVX2=1 for the AVX2 kernel), then ./Elevator.benchmark
+**********************************************************************************/
+
+#include "ElevatorTable.h"
+#include "TravelTimes.h"
+#include "Configuration.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+  constexpr std::size_t NumberOfQueries = 4096;
+  constexpr std::size_t Evaluations = 1000000;  // per kernel and size, spread over the queries
+  constexpr std::size_t SortEvaluations = Evaluations / 20;
+
+  /**
+   * \brief The state read by the dispatcher before the table: one object per elevator, behind a pointer.
+   */
+  struct Car
+  {
+    Floors::FloorNumber m_floor;
+    Direction m_direction;
+    ElevatorStatus m_status;
+    unsigned int m_load;
+
+    bool Available(const Floors::FloorNumber startFloor, const Direction direction) const
+    {
+      if (m_status == ElevatorStatus::OutOfOrder || m_load >= Configuration::Elevator::Capacity)
+        return false;
+
+      if (m_status == ElevatorStatus::Idle || m_direction == Direction::None)
+        return true;
+
+      return direction == m_direction
+        && ((m_direction == Direction::Up && startFloor > m_floor) || (m_direction == Direction::Down && startFloor < m_floor));
+    }
+
+    std::chrono::milliseconds EstimatedTime(const Floors::FloorNumber startFloor) const
+    {
+      const auto stopTime = 2 * Configuration::Elevator::DoorsOperationTime + Configuration::Elevator::EnterAndExitTime;
+      return TravelTimes::Get(m_floor, startFloor) + m_load * stopTime;
+    }
+  };
+
+  struct HallCall
+  {
+    Floors::FloorNumber m_startFloor;
+    Floors::FloorNumber m_destinationFloor;
+  };
+
+  /**
+   * \brief As Management::Assign before the table: sort by estimated time, then the first available.
+   */
+  int SortAndScan(std::vector<std::unique_ptr<Car>>& cars, const HallCall& call)
+  {
+    const auto direction = call.m_destinationFloor > call.m_startFloor ? Direction::Up : Direction::Down;
+
+    std::sort(cars.begin(), cars.end(),
+      [&call](const auto& a, const auto& b) { return a->EstimatedTime(call.m_startFloor) < b->EstimatedTime(call.m_startFloor); });
+
+    for (std::size_t index = 0; index < cars.size(); ++index)
+    {
+      if (cars[index]->Available(call.m_startFloor, direction))
+        return static_cast<int>(index);
+    }
+
+    return -1;
+  }
+
+  template <typename Function>
+  double NanosecondsPerEvaluation(Function function, const std::size_t evaluations, long long& checksum)
+  {
+    const auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t evaluation = 0; evaluation < evaluations; ++evaluation)
+      checksum += function(evaluation % NumberOfQueries);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    return static_cast<double>(elapsed.count()) / evaluations;
+  }
+}
+
+int main()
+{
+  std::default_random_engine engine(12345);
+  std::uniform_int_distribution<Floors::FloorNumber> floors(Floors::BottomFloor, Floors::TopFloor);
+  std::uniform_int_distribution<int> directions(-1, 1);
+  std::uniform_int_distribution<int> statuses(0, 9);
+  std::uniform_int_distribution<unsigned int> loads(0, Configuration::Elevator::Capacity);
+
+  std::vector<HallCall> calls;
+
+  while (calls.size() < NumberOfQueries)
+  {
+    const HallCall call{ floors(engine), floors(engine) };
+
+    if (call.m_startFloor != call.m_destinationFloor)
+      calls.push_back(call);
+  }
+
+  std::cout << "Floors: " << Floors::TotalFloors << ", evaluations per measure: " << Evaluations << " (sort and scan " << SortEvaluations << ")\n\n";
+  std::cout << std::setw(10) << "elevators" << std::setw(16) << "sort and scan" << std::setw(12) << "scalar"
+    << std::setw(12) << "SSE2" << std::setw(12) << "AVX2" << std::setw(22) << "speedup vs scalar" << '\n';
+
+  const ElevatorTable::Kernel kernels[] = { ElevatorTable::Kernel::Scalar, ElevatorTable::Kernel::Sse2, ElevatorTable::Kernel::Avx2 };
+
+  for (const std::size_t numberOfElevators : { 32U, 64U, 128U, 256U })
+  {
+    ElevatorTable table(numberOfElevators);
+    std::vector<std::unique_ptr<Car>> cars;
+
+    for (unsigned int index = 0; index < numberOfElevators; ++index)
+    {
+      const auto status = statuses(engine);
+      const auto elevatorStatus = status == 0 ? ElevatorStatus::OutOfOrder : status < 4 ? ElevatorStatus::Idle : status < 6 ? ElevatorStatus::PeopleEnterAndExit : ElevatorStatus::Moving;
+      const auto direction = elevatorStatus == ElevatorStatus::Idle ? Direction::None : static_cast<Direction>(directions(engine));
+
+      cars.push_back(std::make_unique<Car>(Car{ floors(engine), direction, elevatorStatus, loads(engine) }));
+      table.Set(index, cars.back()->m_floor, direction, elevatorStatus, cars.back()->m_load, Floors::BottomFloor, Floors::TopFloor);
+    }
+
+    table.Refresh();
+
+    std::vector<ElevatorTable::Query> queries;
+
+    for (const auto& call : calls)
+      queries.push_back(table.GetQuery(call.m_startFloor, call.m_destinationFloor));
+
+    // Every kernel must choose the same elevator
+    for (const auto& query : queries)
+    {
+      const auto expected = table.Best(query, ElevatorTable::Kernel::Scalar);
+
+      for (const auto kernel : kernels)
+      {
+        if (ElevatorTable::IsCompiled(kernel) && table.Best(query, kernel) != expected)
+        {
+          std::cerr << "Kernel " << ElevatorTable::GetName(kernel) << " differs from the scalar one\n";
+          return 1;
+        }
+      }
+    }
+
+    long long checksum = 0;
+
+    const auto sortAndScan = NanosecondsPerEvaluation([&cars, &calls](const std::size_t query) { return SortAndScan(cars, calls[query]); }, SortEvaluations, checksum);
+
+    double times[3] = {};
+
+    for (std::size_t kernel = 0; kernel < 3; ++kernel)
+    {
+      if (ElevatorTable::IsCompiled(kernels[kernel]))
+        times[kernel] = NanosecondsPerEvaluation([&table, &queries, &kernels, kernel](const std::size_t query) { return table.Best(queries[query], kernels[kernel]); }, Evaluations, checksum);
+    }
+
+    const auto fastest = times[2] > 0.0 ? times[2] : times[1] > 0.0 ? times[1] : times[0];
+
+    std::cout << std::fixed << std::setprecision(1) << std::setw(10) << numberOfElevators << std::setw(13) << sortAndScan << " ns";
+
+    for (const auto time : times)
+    {
+      if (time > 0.0)
+        std::cout << std::setw(9) << time << " ns";
+      else
+        std::cout << std::setw(12) << "-";
+    }
+
+    std::cout << std::setw(21) << times[0] / fastest << "x" << "  (checksum " << checksum << ")\n";
+  }
+
+  return 0;
+}
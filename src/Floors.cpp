@@ -2,58 +2,153 @@
 
 #include <mutex>
 #include <sstream>
+#include <utility>
 
 #include "Call.h"
 #include "People.h"
+#include "Checkpoint.h"
 #include "Log.h"
 
 
 Floors::Floors()
 {
-  for (FloorNumber floorNumber = 0; floorNumber < TotalFloors; ++floorNumber)
-    m_stops.emplace_back(false, Direction::None);
+  m_stops.resize(TotalFloors);
 
   m_log.SetTraceId("Building");
 }
 
-bool Floors::SetStop(const std::shared_ptr<Call>& call, const bool destinationOnly)
+/**
+ * \brief Add a floor call: the person is waiting on the start floor.
+ */
+bool Floors::SetStop(const std::shared_ptr<Call>& call)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
 
   if (!call->IsValid())
     return false;
 
-  if (!destinationOnly)
+  ++m_stops[call->GetStartFloor()].m_calls[Index(call->GetDirection())];
+
+  Metrics::Add(Metrics::GetFloor(call->GetStartFloor()).m_waiting[Index(call->GetDirection())], 1);
+  PublishStop(call->GetStartFloor());
+
+  return true;
+}
+
+/**
+ * \brief The person left the start floor: the floor call is replaced by the destination.
+ */
+void Floors::PersonEntered(const std::shared_ptr<Call>& call)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (!call->IsValid())
+    return;
+
+  auto& calls = m_stops[call->GetStartFloor()].m_calls[Index(call->GetDirection())];
+
+  if (calls > 0)
   {
-    m_stops[call->GetStartFloor()].first = true;
+    --calls;
+    Metrics::Add(Metrics::GetFloor(call->GetStartFloor()).m_waiting[Index(call->GetDirection())], -1);
+  }
+
+  ++m_stops[call->GetDestinationFloor()].m_destinations[Index(call->GetDirection())];
+
+  PublishStop(call->GetStartFloor());
+  PublishStop(call->GetDestinationFloor());
+}
 
-    m_stops[call->GetStartFloor()].second =
-      m_stops[call->GetStartFloor()].second != Direction::None &&
-      m_stops[call->GetStartFloor()].second != call->GetDirection()
-      ? Direction::Both
-      : call->GetDirection();
+/**
+ * \brief The person left the floor before the elevator arrived: the floor call is answered by nobody.
+ */
+void Floors::CallCancelled(const std::shared_ptr<Call>& call)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (!call->IsValid())
+    return;
+
+  auto& calls = m_stops[call->GetStartFloor()].m_calls[Index(call->GetDirection())];
+
+  if (calls > 0)
+  {
+    --calls;
+    Metrics::Add(Metrics::GetFloor(call->GetStartFloor()).m_waiting[Index(call->GetDirection())], -1);
   }
 
-  m_stops[call->GetDestinationFloor()].first = true;
+  PublishStop(call->GetStartFloor());
+}
 
-  m_stops[call->GetDestinationFloor()].second =
-    m_stops[call->GetDestinationFloor()].second != Direction::None &&
-    m_stops[call->GetDestinationFloor()].second != call->GetDirection()
-      ? Direction::Both
-      : call->GetDirection();
+void Floors::Clear(const bool destinations)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
 
-  return true;
+  for (FloorNumber floor = BottomFloor; IsValid(floor); ++floor)
+  {
+    auto& stop = m_stops[floor];
+
+    for (unsigned int direction = 0; direction < 2; ++direction)
+    {
+      Metrics::Add(Metrics::GetFloor(floor).m_waiting[direction], -static_cast<std::int64_t>(stop.m_calls[direction]));
+      stop.m_calls[direction] = 0;
+
+      if (destinations)
+        stop.m_destinations[direction] = 0;
+    }
+
+    PublishStop(floor);
+  }
 }
 
-Floors::FloorNumber Floors::GetNextStop(const FloorNumber currentFloor, Direction& currentDirection)
+/**
+ * \brief The person reached the destination.
+ */
+void Floors::PersonExited(const std::shared_ptr<Call>& call)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (!call->IsValid())
+    return;
+
+  auto& destinations = m_stops[call->GetDestinationFloor()].m_destinations[Index(call->GetDirection())];
+
+  if (destinations > 0)
+    --destinations;
+
+  PublishStop(call->GetDestinationFloor());
+}
+
+/**
+ * \brief Update the bit of a floor in the published stops. Called with the lock held.
+ */
+void Floors::PublishStop(const FloorNumber floor)
+{
+  if (m_stopsGauge == nullptr || floor >= 64)
+    return;
+
+  const auto bit = std::int64_t(1) << floor;
+  const auto stops = m_stopsGauge->load(std::memory_order_relaxed);
+
+  Metrics::Set(*m_stopsGauge, IsStop(floor, true) ? (stops | bit) : (stops & ~bit));
+}
+
+/**
+ * \brief Search the next stop.
+ * \param currentFloor Current floor of the elevator.
+ * \param currentDirection Current direction of the elevator, changed if there are no more stops in that direction.
+ * \param floorCalls If false only the destinations of the people inside are considered (i.e. the elevator is full).
+ * \return The next floor to reach or InvalidFloor if there are no stops.
+ */
+Floors::FloorNumber Floors::GetNextStop(const FloorNumber currentFloor, Direction& currentDirection, const bool floorCalls)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
 
   if (!IsValid(currentFloor))
     return InvalidFloor;
 
   if (currentDirection == Direction::None)
-    currentDirection = currentFloor < TotalFloors / 2U ? Direction::Down : Direction::Up;
+    currentDirection = NearestStopDirection(currentFloor, floorCalls);
 
   FloorNumber searchStartFloor = InvalidFloor;
 
@@ -67,7 +162,7 @@ Floors::FloorNumber Floors::GetNextStop(const FloorNumber currentFloor, Directio
     searchStartFloor = currentFloor != BottomFloor ? currentFloor : TopFloor;
   }
 
-  FloorNumber nextStop = Search(searchStartFloor, currentDirection);
+  FloorNumber nextStop = Search(searchStartFloor, currentDirection, floorCalls);
 
   // One more search attempt for every direction, changing the search start floor:
   // top floor for down and bottom floor for up
@@ -79,7 +174,7 @@ Floors::FloorNumber Floors::GetNextStop(const FloorNumber currentFloor, Directio
       currentDirection = (currentDirection == Direction::Up ? Direction::Down : Direction::Up);
       searchStartFloor = (currentDirection == Direction::Up ? BottomFloor : TopFloor);
 
-      nextStop = Search(searchStartFloor, currentDirection);
+      nextStop = Search(searchStartFloor, currentDirection, floorCalls);
     }
   }
 
@@ -88,88 +183,162 @@ Floors::FloorNumber Floors::GetNextStop(const FloorNumber currentFloor, Directio
   return nextStop;
 }
 
-People& Floors::GetPeople()
+bool Floors::HasStops()
 {
-  static People people("Building");
-  return people;
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  for (FloorNumber floor = BottomFloor; IsValid(floor); ++floor)
+    if (IsStop(floor, true))
+      return true;
+
+  return false;
 }
 
-Floors::FloorNumber Floors::Search(const FloorNumber startFloor, const Direction direction)
+/**
+ * \brief Direction to take, from a standstill, to reach the nearest stop.
+ */
+Direction Floors::NearestStopDirection(const FloorNumber currentFloor, const bool floorCalls) const
 {
-  if (!IsValid(startFloor) || (direction != Direction::Up && direction != Direction::Down))
-    return InvalidFloor;
+  for (FloorNumber distance = 0; distance < TotalFloors; ++distance)
+  {
+    const auto above = currentFloor + distance;
+    const auto below = currentFloor - distance; // wraps to an invalid floor below the bottom floor
 
-  if(direction == Direction::Up)
+    if (IsValid(above) && IsStop(above, floorCalls))
+    {
+      if (distance > 0)
+        return Direction::Up;
+
+      // Stop on the current floor: take the direction of the people waiting
+      const auto& stop = m_stops[above];
+      return stop.m_calls[Index(Direction::Up)] + stop.m_destinations[Index(Direction::Up)] > 0 ? Direction::Up : Direction::Down;
+    }
+
+    if (IsValid(below) && IsStop(below, floorCalls))
+      return Direction::Down;
+  }
+
+  return currentFloor < TotalFloors / 2U ? Direction::Down : Direction::Up;
+}
+
+bool Floors::IsStop(const FloorNumber floor, const bool floorCalls) const
+{
+  const auto& stop = m_stops[floor];
+
+  return stop.m_destinations[0] + stop.m_destinations[1] > 0 || (floorCalls && stop.m_calls[0] + stop.m_calls[1] > 0);
+}
+
+void Floors::Serialize(CheckpointWriter& writer)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  writer.Write(static_cast<std::uint32_t>(m_stops.size()));
+
+  for (const auto& stop : m_stops)
   {
-  for (FloorNumber floor = startFloor; IsValid(floor); ++floor)
-    if (m_stops[floor].first && (m_stops[floor].second == Direction::Up || m_stops[floor].second == Direction::Both))
-      return floor;
+    writer.Write(stop.m_calls[0]);
+    writer.Write(stop.m_calls[1]);
+    writer.Write(stop.m_destinations[0]);
+    writer.Write(stop.m_destinations[1]);
   }
-  else if (direction == Direction::Down)
+}
+
+bool Floors::Deserialize(CheckpointReader& reader)
+{
+  std::uint32_t count = 0;
+
+  if (!reader.Read(count) || count != TotalFloors)
+    return false;
+
+  FloorStops stops(count);
+
+  for (auto& stop : stops)
   {
-    for (FloorNumber floor = startFloor; IsValid(floor); --floor)
-      if (m_stops[floor].first && (m_stops[floor].second == Direction::Down || m_stops[floor].second == Direction::Both))
-        return floor;
+    if (!reader.Read(stop.m_calls[0]) || !reader.Read(stop.m_calls[1]) || !reader.Read(stop.m_destinations[0]) || !reader.Read(stop.m_destinations[1]))
+      return false;
   }
 
-  return InvalidFloor;
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  for (FloorNumber floor = BottomFloor; IsValid(floor); ++floor)
+  {
+    for (unsigned int direction = 0; direction < 2; ++direction)
+    {
+      const auto delta = static_cast<std::int64_t>(stops[floor].m_calls[direction]) - static_cast<std::int64_t>(m_stops[floor].m_calls[direction]);
+      Metrics::Add(Metrics::GetFloor(floor).m_waiting[direction], delta);
+    }
+  }
+
+  m_stops = std::move(stops);
+
+  for (FloorNumber floor = BottomFloor; IsValid(floor); ++floor)
+    PublishStop(floor);
+
+  return true;
 }
 
-void Floors::ClearStop(const FloorNumber floor, const Direction direction)
+People& Floors::GetPeople()
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  static People people("Building", &Metrics::Get().m_peopleWaiting, "Building people");
+  return people;
+}
 
-  if (!IsValid(floor))
-    return;
+Floors::FloorNumber Floors::Search(const FloorNumber startFloor, const Direction direction, const bool floorCalls)
+{
+  if (!IsValid(startFloor) || (direction != Direction::Up && direction != Direction::Down))
+    return InvalidFloor;
 
-  if (m_stops[floor].second == Direction::Up || m_stops[floor].second == Direction::Down)
-  {
-    m_stops[floor].first = false;
-    m_stops[floor].second = Direction::None;
+  const auto index = Index(direction);
+  const auto isStop = [this, index, floorCalls](const FloorNumber floor)
+    { return m_stops[floor].m_destinations[index] > 0 || (floorCalls && m_stops[floor].m_calls[index] > 0); };
 
-    m_log.Trace("Cleared floor " + std::to_string(floor), Log::TraceLevel::Debug);
+  if(direction == Direction::Up)
+  {
+    for (FloorNumber floor = startFloor; IsValid(floor); ++floor)
+      if (isStop(floor))
+        return floor;
   }
-  else if (m_stops[floor].second == Direction::Both)
+  else if (direction == Direction::Down)
   {
-    m_stops[floor].second = direction == Direction::Up ? Direction::Down : Direction::Up;
-
-    std::stringstream message;
-    message << "Cleared floor " << floor << "direction " << (direction == Direction::Up ? "UP" : "DOWN");
-    m_log.Trace(message, Log::TraceLevel::Debug);
+    for (FloorNumber floor = startFloor; IsValid(floor); --floor)
+      if (isStop(floor))
+        return floor;
   }
+
+  return InvalidFloor;
 }
 
+/**
+ * \brief Trace the stops: uppercase for the floor calls, lowercase for the destinations, followed by the count.
+ */
 void Floors::Trace(const FloorNumber currentFloor)
 {
   std::stringstream message;
   message << "Floors stops: ";
 
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
   for (FloorNumber floor = BottomFloor; IsValid(floor); ++floor)
   {
-    std::string direction;
+    const auto& stop = m_stops[floor];
 
-    switch (m_stops[floor].second)
-    {
-    case Direction::Up: 
-      direction = "U";
-      break;
-    case Direction::Down: 
-      direction = "D";
-      break;
-    case Direction::Both: 
-      direction = "B";
-      break;
-
-    default:
-    case Direction::None:
-      direction = "None";
-      break;
-    }
+    if (stop.m_calls[0] + stop.m_calls[1] + stop.m_destinations[0] + stop.m_destinations[1] == 0)
+      continue;
 
     const auto currentFloorIndicator = IsValid(currentFloor) && currentFloor == floor ? "*" : "";
 
-    if (m_stops[floor].first)
-      message << "[" << currentFloorIndicator << std::to_string(floor) << direction << "]";
+    message << "[" << currentFloorIndicator << std::to_string(floor);
+
+    if (stop.m_calls[0] > 0)
+      message << " U" << stop.m_calls[0];
+    if (stop.m_calls[1] > 0)
+      message << " D" << stop.m_calls[1];
+    if (stop.m_destinations[0] > 0)
+      message << " u" << stop.m_destinations[0];
+    if (stop.m_destinations[1] > 0)
+      message << " d" << stop.m_destinations[1];
+
+    message << "]";
   }
 
   m_log.Trace(message, Log::TraceLevel::Verbose);
@@ -9,9 +9,10 @@
 
 #include "Configuration.h"
 #include "Log.h"
+#include "LockStats.h"
+#include "Metrics.h"
 
 #include <vector>
-#include <mutex>
 
 enum class Direction
 {
@@ -21,8 +22,16 @@ enum class Direction
   Both,
 };
 
-typedef std::pair<bool, Direction> Stop;
-typedef std::vector<Stop> FloorStops;
+/**
+ * \brief Reference counted stops of a floor, per direction (Up, Down).
+ */
+struct FloorStop
+{
+  unsigned int m_calls[2] = { 0, 0 };        // people waiting on the floor for the elevator
+  unsigned int m_destinations[2] = { 0, 0 }; // people inside the elevator going to the floor
+};
+
+typedef std::vector<FloorStop> FloorStops;
 
 class Floors final
 {
@@ -32,6 +41,7 @@ public: // Types, constants and static functions
     static constexpr FloorNumber TotalFloors = Configuration::Building::NumberOfFloors;
     static constexpr FloorNumber BottomFloor = 0U;
     static constexpr FloorNumber TopFloor = (TotalFloors - 1);
+    static constexpr FloorNumber Lobby = BottomFloor;
     static constexpr FloorNumber InvalidFloor = static_cast<FloorNumber>(-1);
 
     static bool IsValid(const FloorNumber floorNumber) { return floorNumber >= BottomFloor && floorNumber <= TopFloor; }
@@ -40,25 +50,51 @@ public:
   Floors();
 
 public:
-  bool SetStop(const class std::shared_ptr<class Call>& call, bool destinationOnly = false);
-  void ClearStop(const FloorNumber floor, const Direction direction);
+  bool SetStop(const class std::shared_ptr<class Call>& call);
+
+  void PersonEntered(const class std::shared_ptr<class Call>& call);
+  void PersonExited(const class std::shared_ptr<class Call>& call);
+  void CallCancelled(const class std::shared_ptr<class Call>& call);
+
+  /**
+   * \brief Remove the floor calls and, if requested, the destinations of the people inside.
+   */
+  void Clear(const bool destinations);
+
+  FloorNumber GetNextStop(const FloorNumber currentFloor, Direction& currentDirection, const bool floorCalls = true);
 
-  FloorNumber GetNextStop(const FloorNumber currentFloor, Direction& currentDirection);
+  bool HasStops();
 
   static class People& GetPeople();
 
   void Trace(const FloorNumber currentFloor);
 
+  void Serialize(class CheckpointWriter& writer);
+  bool Deserialize(class CheckpointReader& reader);
+
   void SetId(const std::string& id) { m_log.SetTraceId(id); }
   std::string GetId() const { return m_log.GetTraceId(); }
 
+  /**
+   * \brief Set the gauge where the floors with a stop are published, as a bit mask.
+   */
+  void SetStopsGauge(Metrics::Gauge* stopsGauge) { m_stopsGauge = stopsGauge; }
+
 private:
-  FloorNumber Search(const FloorNumber startFloor, const Direction direction);
+  void PublishStop(const FloorNumber floor);
+
+  FloorNumber Search(const FloorNumber startFloor, const Direction direction, const bool floorCalls);
+  Direction NearestStopDirection(const FloorNumber currentFloor, const bool floorCalls) const;
+  bool IsStop(const FloorNumber floor, const bool floorCalls) const;
+
+  static unsigned int Index(const Direction direction) { return direction == Direction::Up ? 0U : 1U; }
 
 private:
   FloorStops m_stops;
 
-  std::mutex m_mutex;
+  InstrumentedMutex m_mutex{ "Floors" };
+
+  Metrics::Gauge* m_stopsGauge = nullptr; // [Optional] published stops
 
   Log m_log;
 };
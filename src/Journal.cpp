@@ -0,0 +1,71 @@
+#include "Journal.h"
+
+#include "SharedMemory.h"
+#include "Configuration.h"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+using namespace Configuration::Journal;
+
+namespace
+{
+  Journal::Slot* GetSlots(Journal::Header* header) { return reinterpret_cast<Journal::Slot*>(header + 1); }
+}
+
+void Journal::Record(const EventType type, const unsigned int elevator, const unsigned int floor, const std::uint64_t callId, const int value)
+{
+  static Header* const header = Open();
+
+  if (header == nullptr)
+    return;
+
+  EventData data;
+  data.m_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+  data.m_callId = callId;
+  data.m_type = type;
+  data.m_elevator = static_cast<std::uint16_t>(elevator);
+  data.m_floor = static_cast<std::int16_t>(floor);
+  data.m_value = static_cast<std::int16_t>(value);
+
+  const auto index = header->m_nextIndex.fetch_add(1, std::memory_order_relaxed);
+  auto& slot = GetSlots(header)[index % header->m_capacity];
+
+  // A reader seeing the new sequence sees the whole event
+  slot.m_sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.m_data, &data, sizeof(data));
+  slot.m_sequence.store(index + 1, std::memory_order_release);
+}
+
+Journal::Header* Journal::Open()
+{
+  if (!Enabled || Capacity == 0)
+    return nullptr;
+
+  // Never destroyed: events can be recorded until the very end of the process
+  static auto file = new SharedMemory();
+
+  if (!file->MapFile(FileName, sizeof(Header) + Capacity * sizeof(Slot)))
+    return nullptr;
+
+  auto header = static_cast<Header*>(file->GetAddress());
+
+  // A journal with the same layout is continued, anything else is overwritten
+  if (header->m_magic != Magic || header->m_version != Version || header->m_capacity != Capacity || header->m_slotSize != sizeof(Slot))
+  {
+    std::memset(file->GetAddress(), 0, file->GetSize());
+
+    header = new (file->GetAddress()) Header();
+    header->m_version = Version;
+    header->m_capacity = static_cast<std::uint32_t>(Capacity);
+    header->m_slotSize = sizeof(Slot);
+    header->m_nextIndex.store(0, std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_release);
+    header->m_magic = Magic;
+  }
+
+  return header;
+}
@@ -0,0 +1,87 @@
+/**********************************************************************************
+*        File: Journal.h
+* Description: Append-only journal of the simulation events, in a memory mapped ring file.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The file outlives the process: after a crash the last events are still
+*              in the page cache and then on disk.
+**********************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "The journal requires lock-free 64 bit atomics");
+
+/**
+ * \brief Fixed size events in a ring: recording an event costs an index increment and a copy of 24 bytes.
+ *
+ * File layout: Header, then Header::m_capacity slots. The event with index i is in the slot i % capacity,
+ * with m_sequence = i + 1. A slot with a sequence of 0 is empty or being written.
+ * A new run appends to the events of the previous one, starting with a Started event.
+ */
+class Journal final
+{
+public:
+  static constexpr std::uint32_t Magic = 0x4C4E524A; // "JRNL"
+  static constexpr std::uint32_t Version = 1;
+
+  enum class EventType : std::uint16_t
+  {
+    Started = 1,       // value: number of elevators
+    CallCreated,       // floor: start floor, value: destination floor
+    CallAssigned,
+    CallTransferred,   // floor: transfer floor, value: final destination floor
+    PersonBoarded,
+    PersonAlighted,
+    DoorsOpened,
+    DoorsClosed,
+    FloorReached,
+    DirectionChanged,  // value: Direction
+    CallAbandoned,     // floor: start floor, value: 0 gave up, 1 took the stairs, 2 called again
+    CallReallocated,   // elevator: new elevator, floor: start floor, value: previous elevator
+  };
+
+  struct EventData
+  {
+    std::int64_t m_time;     // microseconds since the epoch (system clock)
+    std::uint64_t m_callId;  // 0 if not related to a call
+    EventType m_type;
+    std::uint16_t m_elevator;
+    std::int16_t m_floor;
+    std::int16_t m_value;
+  };
+
+  struct Slot
+  {
+    std::atomic<std::uint64_t> m_sequence;
+    EventData m_data;
+  };
+
+  struct Header
+  {
+    std::uint32_t m_magic;
+    std::uint32_t m_version;
+    std::uint32_t m_capacity;
+    std::uint32_t m_slotSize;
+    std::atomic<std::uint64_t> m_nextIndex;
+  };
+
+  static constexpr std::uint16_t NoElevator = 0xFFFF;
+
+public:
+  Journal() = delete;
+
+  /**
+   * \brief Record an event. Thread safe and lock free; does nothing if the journal is disabled or not available.
+   * \param type Type of the event.
+   * \param elevator Index of the elevator, NoElevator if none.
+   * \param floor Floor of the event, if any.
+   * \param callId Id of the call, 0 if none.
+   * \param value Additional value, see EventType.
+   */
+  static void Record(const EventType type, const unsigned int elevator, const unsigned int floor, const std::uint64_t callId = 0, const int value = 0);
+
+private:
+  static Header* Open();
+};
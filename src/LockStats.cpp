@@ -0,0 +1,152 @@
+#include "LockStats.h"
+
+#ifdef ELEVATOR_LOCK_STATS
+
+#include <map>
+#include <string>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+  struct Registry
+  {
+    std::mutex m_mutex;
+    std::map<std::string, LockStats::Entry*> m_entries;
+  };
+
+  // Never destroyed: the log queue mutex is used until the very end of the process
+  Registry& GetRegistry()
+  {
+    static auto registry = new Registry();
+    return *registry;
+  }
+
+  std::uint64_t Load(const std::atomic<std::uint64_t>& value) { return value.load(std::memory_order_relaxed); }
+
+  std::string ToString(const std::uint64_t nanoseconds)
+  {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+
+    if (nanoseconds < 1000000)
+      text << nanoseconds / 1000.0 << "us";
+    else
+      text << nanoseconds / 1000000.0 << "ms";
+
+    return text.str();
+  }
+
+  std::string ToString(const LockStats::Histogram& histogram, const std::uint64_t count)
+  {
+    std::ostringstream text;
+    text << "avg " << ToString(count > 0 ? Load(histogram.m_totalNanoseconds) / count : 0)
+      << ", max " << ToString(Load(histogram.m_maxNanoseconds)) << ", buckets [";
+
+    for (unsigned int bucket = 0; bucket <= LockStats::Buckets; ++bucket)
+      text << (bucket > 0 ? " " : "") << Load(histogram.m_buckets[bucket]);
+
+    text << "]";
+    return text.str();
+  }
+}
+
+LockStats::Entry& LockStats::Register(const char* name)
+{
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+  auto& entry = registry.m_entries[name];
+
+  if (entry == nullptr)
+    entry = new Entry(); // value initialized: all the counters are zero
+
+  return *entry;
+}
+
+void LockStats::Record(Histogram& histogram, const std::chrono::steady_clock::duration time)
+{
+  const auto nanoseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+
+  unsigned int bucket = 0;
+  std::uint64_t bound = 1000;
+
+  while (bucket < Buckets && nanoseconds > bound)
+  {
+    ++bucket;
+    bound *= 4;
+  }
+
+  histogram.m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  histogram.m_totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+  auto max = histogram.m_maxNanoseconds.load(std::memory_order_relaxed);
+  while (nanoseconds > max && !histogram.m_maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+  {
+  }
+}
+
+void LockStats::TraceReport(ILog& log)
+{
+  auto& registry = GetRegistry();
+
+  std::stringstream report;
+  report << "Lock statistics (histogram bounds 1us, 4us, 16us ... 262ms, over)";
+
+  {
+    std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+    for (const auto& entry : registry.m_entries)
+    {
+      const auto acquisitions = Load(entry.second->m_acquisitions);
+
+      report << "\n  " << entry.first << ": " << acquisitions << " acquisitions, " << Load(entry.second->m_contended) << " contended";
+      report << "\n    wait: " << ToString(entry.second->m_waitTime, acquisitions);
+      report << "\n    hold: " << ToString(entry.second->m_holdTime, acquisitions);
+    }
+  }
+
+  log.Trace(report);
+}
+
+void InstrumentedMutex::lock()
+{
+  const auto requestTime = std::chrono::steady_clock::now();
+
+  if (m_mutex.try_lock())
+  {
+    m_acquisitionTime = requestTime;
+    LockStats::Record(m_stats.m_waitTime, std::chrono::steady_clock::duration::zero());
+  }
+  else
+  {
+    m_mutex.lock();
+    m_acquisitionTime = std::chrono::steady_clock::now();
+    LockStats::Record(m_stats.m_waitTime, m_acquisitionTime - requestTime);
+    m_stats.m_contended.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  m_stats.m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+void InstrumentedMutex::unlock()
+{
+  const auto holdTime = std::chrono::steady_clock::now() - m_acquisitionTime;
+  m_mutex.unlock();
+
+  LockStats::Record(m_stats.m_holdTime, holdTime);
+}
+
+bool InstrumentedMutex::try_lock()
+{
+  if (!m_mutex.try_lock())
+    return false;
+
+  m_acquisitionTime = std::chrono::steady_clock::now();
+  LockStats::Record(m_stats.m_waitTime, std::chrono::steady_clock::duration::zero());
+  m_stats.m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+  return true;
+}
+
+#endif
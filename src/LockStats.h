@@ -0,0 +1,112 @@
+/**********************************************************************************
+*        File: LockStats.h
+* Description: Mutex wrapper recording acquisitions, wait and hold times per named lock.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: Enabled only when built with ELEVATOR_LOCK_STATS (make LOCK_STATS=1):
+*              otherwise InstrumentedMutex is a plain std::mutex.
+**********************************************************************************/
+
+#pragma once
+
+#include "ILog.h"
+
+#include <mutex>
+#include <condition_variable>
+
+#ifdef ELEVATOR_LOCK_STATS
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * \brief Statistics of the locks, grouped by name: all the mutexes with the same name share the same entry.
+ */
+class LockStats final
+{
+public:
+  static constexpr unsigned int Buckets = 10;
+
+  /**
+   * \brief Histogram with power of 4 bounds: 1us, 4us, 16us ... 262ms, the last bucket counts the longer times.
+   */
+  struct Histogram
+  {
+    std::atomic<std::uint64_t> m_buckets[Buckets + 1];
+    std::atomic<std::uint64_t> m_totalNanoseconds;
+    std::atomic<std::uint64_t> m_maxNanoseconds;
+  };
+
+  struct Entry
+  {
+    std::atomic<std::uint64_t> m_acquisitions;
+    std::atomic<std::uint64_t> m_contended;   // acquisitions which had to wait
+    Histogram m_waitTime;
+    Histogram m_holdTime;
+  };
+
+public:
+  LockStats() = delete;
+
+  /**
+   * \brief Get the entry of a lock name, creating it at the first use.
+   */
+  static Entry& Register(const char* name);
+
+  static void Record(Histogram& histogram, const std::chrono::steady_clock::duration time);
+
+  /**
+   * \brief Trace the statistics of all the locks.
+   */
+  static void TraceReport(ILog& log);
+};
+
+/**
+ * \brief Mutex recording its statistics. Meets the Lockable requirements: use it with
+ * std::lock_guard, std::unique_lock and std::condition_variable_any.
+ */
+class InstrumentedMutex final
+{
+public:
+  typedef std::unique_lock<InstrumentedMutex> UniqueLock;
+  typedef std::condition_variable_any ConditionVariable;
+
+  explicit InstrumentedMutex(const char* name) : m_stats(LockStats::Register(name)) {}
+
+  InstrumentedMutex(const InstrumentedMutex&) = delete;
+  InstrumentedMutex& operator=(const InstrumentedMutex&) = delete;
+
+public:
+  void lock();
+  void unlock();
+  bool try_lock();
+
+private:
+  std::mutex m_mutex;
+  LockStats::Entry& m_stats;
+  std::chrono::steady_clock::time_point m_acquisitionTime;  // written only by the owner
+};
+
+#else
+
+class LockStats final
+{
+public:
+  LockStats() = delete;
+
+  static void TraceReport(ILog&) {}
+};
+
+/**
+ * \brief Plain mutex: the name is ignored.
+ */
+class InstrumentedMutex final : public std::mutex
+{
+public:
+  typedef std::unique_lock<std::mutex> UniqueLock;
+  typedef std::condition_variable ConditionVariable;
+
+  explicit InstrumentedMutex(const char*) {}
+};
+
+#endif
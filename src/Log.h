@@ -8,13 +8,14 @@
 #pragma once
 
 #include "ILog.h"
+#include "LogRegistry.h"
 #include "Configuration.h"
 
 #include <memory>
 #include <sstream>
 
 /**
- * \brief Implements the log service factory
+ * \brief Lightweight handle of the log service: the component tracing and the shared sink, see LogRegistry.
  */
 class Log final : public ILog
 {
@@ -45,10 +46,7 @@ public:
   void SetTraceLevelFilter(const TraceLevel startLevel) override;
 
 private:
-  std::shared_ptr<ILog>& GetLog(const std::string& traceId);
-
-private:
+  const LogRegistry::Component* m_component;
   std::shared_ptr<ILog> m_implementation;
-  LogType m_logType{ LogType::Default };
 };
 
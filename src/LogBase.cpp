@@ -1,13 +1,20 @@
 #include "LogBase.h"
 
 #include "Watchdog.h"
+#include "Metrics.h"
 #include "Configuration.h"
+#include "AllocStats.h"
 
 #include <sstream>
 #include <utility>
+#include <algorithm>
+
+using namespace Configuration::Log;
 
 std::deque<std::shared_ptr<LogBase::TraceMessage>> LogBase::m_messageQueue;
-std::unique_ptr<std::mutex> LogBase::m_messageQueueMutex{ std::make_unique<std::mutex>() };
+std::unique_ptr<InstrumentedMutex> LogBase::m_messageQueueMutex{ std::make_unique<InstrumentedMutex>("Log queue") };
+InstrumentedMutex::ConditionVariable LogBase::m_spaceAvailable;
+std::uint64_t LogBase::m_droppedMessages{ 0 };
 
 LogBase::TraceLevel LogBase::m_traceLevelFilter{ Configuration::Log::TraceLevel };
 
@@ -29,11 +36,15 @@ LogBase::~LogBase()
 
 void LogBase::Trace(const std::stringstream& message, const TraceLevel level, const std::string& messageSpecificId) 
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Logger);
+
   Enqueue(std::make_shared<TraceMessage>(message.str(), messageSpecificId.empty() ? m_traceId : messageSpecificId, level));
 }
 
 void LogBase::Trace(const std::string& message, const TraceLevel level, const std::string& messageSpecificId) 
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Logger);
+
   Enqueue(std::make_shared<TraceMessage>(message, messageSpecificId.empty() ? m_traceId : messageSpecificId, level));
 }
 
@@ -42,13 +53,67 @@ void LogBase::Enqueue(const std::shared_ptr<TraceMessage>& traceMessage)
 {
   if (m_messageQueueMutex == nullptr) // Preconditions
     return;
-    
-  std::lock_guard<std::mutex> lockMessageQueue(*m_messageQueueMutex);
+
+  if (traceMessage->m_level < m_traceLevelFilter) // would be discarded by the log thread anyway
+    return;
+
+  InstrumentedMutex::UniqueLock lockMessageQueue(*m_messageQueueMutex);
+
+  if (m_messageQueue.size() >= QueueCapacity && !MakeRoom(lockMessageQueue, traceMessage->m_level))
+  {
+    CountDrop();
+    return;
+  }
+
   m_messageQueue.push_back(traceMessage);
+  Metrics::Set(Metrics::Get().m_logQueueDepth, static_cast<std::int64_t>(m_messageQueue.size()));
 
   GetThreadInstance()->Go();
 }
 
+/**
+ * \brief Apply the overflow policy to a full queue. Called with the queue lock held.
+ * \param lock Lock of the queue, released while the Block policy waits.
+ * \param level Level of the message to enqueue.
+ * \return 'true' if the new message can be enqueued, 'false' if it must be dropped.
+ */
+bool LogBase::MakeRoom(InstrumentedMutex::UniqueLock& lock, const TraceLevel level)
+{
+  switch (QueueOverflowPolicy)
+  {
+  case OverflowPolicy::Block:
+    return m_spaceAvailable.wait_for(lock, BlockTimeout, []() { return m_messageQueue.size() < QueueCapacity; });
+
+  case OverflowPolicy::DropOldest:
+    m_messageQueue.pop_front();
+    CountDrop();
+    return true;
+
+  case OverflowPolicy::DropBelowLevel:
+  {
+    if (level < DropLevel)
+      return false;
+
+    const auto lessImportant = std::find_if(m_messageQueue.begin(), m_messageQueue.end(),
+      [](const std::shared_ptr<TraceMessage>& message) { return message->m_level < DropLevel; });
+
+    m_messageQueue.erase(lessImportant != m_messageQueue.end() ? lessImportant : m_messageQueue.begin());
+    CountDrop();
+    return true;
+  }
+
+  case OverflowPolicy::DropNewest:
+  default:
+    return false;
+  }
+}
+
+void LogBase::CountDrop()
+{
+  ++m_droppedMessages;
+  Metrics::Increment(Metrics::Get().m_logMessagesDropped);
+}
+
 std::unique_ptr<LogBase::TraceThread>& LogBase::GetThreadInstance()
 {
   static auto thread = std::make_unique<TraceThread>(this);
@@ -57,14 +122,39 @@ std::unique_ptr<LogBase::TraceThread>& LogBase::GetThreadInstance()
 
 void LogBase::TraceThread::CycleFunction(LogBase* logBase)
 {
-  while (!m_messageQueue.empty() && !StopRequested())
+  AllocStats::Scope allocationScope(AllocStats::Tag::Logger);
+
+  while (!StopRequested())
   {
-    std::lock_guard<std::mutex> lockMessageQueue(*m_messageQueueMutex);
+    std::shared_ptr<TraceMessage> message;
+    std::uint64_t droppedMessages;
 
-    const auto message = std::move(m_messageQueue.front());
-    m_messageQueue.pop_front();
+    {
+      std::lock_guard<InstrumentedMutex> lockMessageQueue(*m_messageQueueMutex);
+
+      if (m_messageQueue.empty())
+        break;
+
+      message = std::move(m_messageQueue.front());
+      m_messageQueue.pop_front();
+      Metrics::Set(Metrics::Get().m_logQueueDepth, static_cast<std::int64_t>(m_messageQueue.size()));
+
+      droppedMessages = m_droppedMessages;
+    }
+
+    // The message is traced without holding the lock: a slow output does not stall the producers
+    m_spaceAvailable.notify_one();
+
+    if (logBase == nullptr)
+      continue;
+
+    if (droppedMessages != m_reportedDrops)
+    {
+      logBase->LogFunction(std::make_shared<TraceMessage>(
+        "** " + std::to_string(droppedMessages - m_reportedDrops) + " MESSAGES DROPPED, LOG QUEUE FULL **", "Log", TraceLevel::Warning));
+      m_reportedDrops = droppedMessages;
+    }
 
-    if(logBase != nullptr)
-      logBase->LogFunction(message);
+    logBase->LogFunction(message);
   }
 }
@@ -9,9 +9,11 @@
 
 #include <deque>
 #include <atomic>
+#include <cstdint>
 
 #include "ILog.h"
 #include "WorkerThread.h"
+#include "LockStats.h"
 
 /**
  * \brief Implements the log basic producer/consumer logic with a message queue and a trace thread.
@@ -26,6 +28,9 @@ private:
 
   protected:
     void CycleFunction(LogBase* logBase) override;
+
+  private:
+    std::uint64_t m_reportedDrops = 0;
   };
 
 protected:
@@ -74,6 +79,9 @@ public: // ILog
 private:
   void Enqueue(const std::shared_ptr<TraceMessage>& traceMessage);
 
+  static bool MakeRoom(InstrumentedMutex::UniqueLock& lock, const TraceLevel level);
+  static void CountDrop();
+
   virtual void LogFunction(const std::shared_ptr<TraceMessage>& message) = 0;
 
   std::unique_ptr<TraceThread>& GetThreadInstance();
@@ -83,7 +91,9 @@ private:
 
 private:
   static std::deque<std::shared_ptr<TraceMessage>> m_messageQueue;
-  static std::unique_ptr<std::mutex> m_messageQueueMutex;
+  static std::unique_ptr<InstrumentedMutex> m_messageQueueMutex;
+  static InstrumentedMutex::ConditionVariable m_spaceAvailable;
+  static std::uint64_t m_droppedMessages; // protected by m_messageQueueMutex
 
   static std::atomic_uint m_refCount;
 
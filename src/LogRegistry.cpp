@@ -0,0 +1,66 @@
+#include "LogRegistry.h"
+
+#include "LogToScreen.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+  constexpr std::size_t NumberOfLogTypes = 2;
+
+  struct Registry
+  {
+    std::mutex m_mutex;
+    std::weak_ptr<ILog> m_sinks[NumberOfLogTypes];
+    std::unordered_map<std::string, std::unique_ptr<LogRegistry::Component>> m_components;
+  };
+
+  // Never destroyed: the handles of static objects can be destroyed after it
+  Registry& GetRegistry()
+  {
+    static auto registry = new Registry();
+    return *registry;
+  }
+}
+
+std::shared_ptr<ILog> LogRegistry::GetSink(const ILog::LogType logType)
+{
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+  auto& sink = registry.m_sinks[static_cast<std::size_t>(logType)];
+  auto implementation = sink.lock();
+
+  if (implementation == nullptr)
+  {
+    switch (logType)
+    {
+    case ILog::LogType::Screen:
+      implementation = std::make_shared<LogToScreen>();
+      break;
+
+    case ILog::LogType::File:
+    default:
+      throw std::invalid_argument("Not yet implemented");
+    }
+
+    sink = implementation;
+  }
+
+  return implementation;
+}
+
+const LogRegistry::Component& LogRegistry::GetComponent(const std::string& traceId)
+{
+  auto& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.m_mutex);
+
+  auto& component = registry.m_components[traceId];
+
+  if (component == nullptr)
+    component = std::make_unique<Component>(Component{ traceId });
+
+  return *component;
+}
@@ -0,0 +1,45 @@
+/**********************************************************************************
+*        File: LogRegistry.h
+* Description: Registry of the log sinks and of the components tracing messages,
+*              shared by all the Log handles.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: A sink is created by the first handle and destroyed with the last one,
+*              stopping the trace thread; the components are kept until the exit.
+**********************************************************************************/
+
+#pragma once
+
+#include "ILog.h"
+
+#include <memory>
+#include <string>
+
+/**
+ * \brief One sink per log type, whatever the number of handles: a handle is a component and its sink.
+ */
+class LogRegistry final
+{
+public:
+  /**
+   * \brief Component tracing messages, registered once per trace id: a handle holds its address, which
+   * identifies it. No numeric id and no level of its own: the level filter is global, in the sink.
+   */
+  struct Component
+  {
+    std::string m_traceId;
+  };
+
+public:
+  LogRegistry() = delete;
+
+  /**
+   * \brief Get the sink of a log type, creating it if no handle holds it.
+   * \throw std::invalid_argument if the log type is not implemented.
+   */
+  static std::shared_ptr<ILog> GetSink(const ILog::LogType logType);
+
+  /**
+   * \brief Get the component of a trace id, registering it at the first use. The reference is valid until the exit.
+   */
+  static const Component& GetComponent(const std::string& traceId);
+};
@@ -1,39 +1,118 @@
 #include "Management.h"
+#include "Elevator.h"
 #include "PeopleCallsGenerator.h"
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include "Dashboard.h"
+#include "LockStats.h"
+#include "AllocStats.h"
+#include "Checkpoint.h"
+#include "TraceEvents.h"
+#include "CallsWriter.h"
 #include "Configuration.h"
 #include "Log.h"
 
 #include <iostream>
+#include <memory>
 #include <string> 
+#include <sstream>
+#include <stdexcept>
 
 using namespace Configuration::CallsGenerator;
 
-int main()
+/**
+ * \brief Usage: Elevator.run [checkpoint file to restore]
+ */
+int main(int argc, char* argv[])
 {
   Log log;
-  log.Trace("Press Enter to stop...");
+  log.Trace("Press Enter to stop, 'c' and Enter to write a checkpoint, 'f <elevator> <o|d|s>' and Enter to inject a fault (out of service, stuck doors, slow)...");
 
   try
   {
+    std::unique_ptr<MetricsServer> metricsServer;
+
+    if (Configuration::Metrics::PublishInSharedMemory && !Metrics::IsPublished())
+      log.Trace("Metrics not published in shared memory: segment in use by another instance", Log::TraceLevel::Warning);
+
+    if (Configuration::Metrics::HttpEndpoint)
+      metricsServer = std::make_unique<MetricsServer>(Configuration::Metrics::HttpPort);
+
     Management elevatorsManagement(Configuration::Building::NumberOfElevators);
 
     PeopleCallsGenerator callsGenerator(elevatorsManagement);
 
+    if (argc > 1 && !Checkpoint::Restore(argv[1], elevatorsManagement, callsGenerator))
+      throw std::runtime_error("checkpoint not restored");
+
+    if (Configuration::CallsOutput::Enabled)
+      CallsWriter::Start(Configuration::CallsOutput::FileName);
+
+    Dashboard dashboard;
+
+    if (Configuration::Dashboard::Enabled)
+    {
+      // Fewer messages: the log scrolls in the rows left by the dashboard
+      log.SetTraceLevelFilter(Configuration::Dashboard::MessageLevel);
+      dashboard.Start();
+    }
+
     switch (GeneratorType)
     {
     case Type::Random:
       callsGenerator.StartRandom(NumberOfCalls);
       break;
+    case Type::Socket:
+      callsGenerator.StartSocket(SocketPath);
+      break;
     case Type::Fixed: 
     default:
       callsGenerator.StartFixed();
     }
 
-    std::cin.get();
+    // From here on the allocations are of the running simulation
+    AllocStats::Mark();
+
+    std::string command;
+
+    while (std::getline(std::cin, command) && !command.empty())
+    {
+      if (command == "c")
+        Checkpoint::Save(Configuration::Checkpoint::FileName, elevatorsManagement, callsGenerator);
+      else if (command[0] == 'f')
+      {
+        std::istringstream arguments(command.substr(1));
+        std::string elevatorId;
+        char type = ' ';
+
+        arguments >> elevatorId >> type;
+
+        const auto fault = type == 'o' ? ElevatorFault::OutOfService : type == 'd' ? ElevatorFault::StuckDoors : type == 's' ? ElevatorFault::Slow : ElevatorFault::None;
+
+        if (fault == ElevatorFault::None || !elevatorsManagement.InjectFault(elevatorId, fault))
+          log.Trace("Unknown fault or elevator: " + command, Log::TraceLevel::Warning);
+      }
+    }
+
+    dashboard.Stop();
+    log.SetTraceLevelFilter(Configuration::Log::TraceLevel);
+
     log.Trace("Shutdown requested...");
 
     callsGenerator.Shutdown();
     elevatorsManagement.Shutdown();
+
+    if (metricsServer)
+      metricsServer->Shutdown();
+
+    CallsWriter::Stop();
+
+    // All the threads recording events are stopped
+    if (Configuration::TraceEvents::Enabled)
+      TraceEvents::Write(Configuration::TraceEvents::FileName);
+
+    LockStats::TraceReport(log);
+    AllocStats::TraceReport(log);
   }
   catch(std::exception& e)
   {
@@ -1,21 +1,112 @@
 #include "Management.h"
 
 #include "Elevator.h"
+#include "TravelTimes.h"
+#include "Configuration.h"
+#include "Metrics.h"
+#include "People.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "TraceEvents.h"
+#include "AllocStats.h"
 
 #include <random>
 #include <cstdlib>
 #include <sstream>
 #include <algorithm>
+#include <numeric>
 
-Management::Management(const unsigned int numberOfElevators)
+namespace
 {
+  /**
+   * \brief Every zone is a range of floors and every floor above the lobby is in a zone with elevators.
+   */
+  constexpr bool ZonesAreValid()
+  {
+    for (const auto& zone : Configuration::Building::Zones)
+    {
+      if (zone.m_lowestFloor > zone.m_highestFloor)
+        return false;
+    }
+
+    for (auto floor = Floors::Lobby + 1; floor < Floors::TotalFloors; ++floor)
+    {
+      auto covered = false;
+
+      for (const auto& zone : Configuration::Building::Zones)
+        covered = covered || (zone.m_numberOfElevators > 0 && floor >= zone.m_lowestFloor && floor <= zone.m_highestFloor);
+
+      if (!covered)
+        return false;
+    }
+
+    return true;
+  }
+}
+
+static_assert(!Configuration::Building::Zoning || ZonesAreValid(), "Every zone must have its lowest floor not above its highest one, and every floor must be in a zone");
+
+Management::Management(const unsigned int numberOfElevators) :
+  m_table(numberOfElevators)
+{
+  const auto& homeFloors = Configuration::Parking::HomeFloors;
+  const auto numberOfHomeFloors = sizeof(homeFloors) / sizeof(homeFloors[0]);
+
   for(auto elevatorIndex = 0U; elevatorIndex < numberOfElevators; ++elevatorIndex)
   {
     const auto elevatorId = std::string(1U, static_cast<char>('A' + elevatorIndex));
-    m_elevators.push_back(std::make_unique<Elevator>(elevatorId));
+    m_elevators.push_back(std::make_unique<Elevator>(elevatorId, elevatorIndex));
+
+    auto& elevator = m_elevators.back();
+    elevator->SetTransferFunction([this](const std::shared_ptr<Call>& call) { Transfer(call); });
+    elevator->SetParkingFunction([this](const Elevator& idleElevator) { return GetParkingFloor(idleElevator); });
+    elevator->SetFailureFunction([this](Elevator& failedElevator, std::vector<std::shared_ptr<Call>>& calls) { Failover(failedElevator, calls); });
+    elevator->SetAvailableFunction([this](const Elevator&) { AssignPending(); });
+    elevator->SetTable(&m_table);
+
+    if (elevatorIndex < numberOfHomeFloors && Floors::IsValid(homeFloors[elevatorIndex]))
+      elevator->SetHomeFloor(homeFloors[elevatorIndex]);
   }
 
   m_log.SetTraceId("Management");
+
+  if (Configuration::Building::Zoning)
+    SetZones();
+
+  // Wired: the elevator threads can start
+  for (const auto& elevator : m_elevators)
+    elevator->Start();
+
+  const auto expressRun = TravelTimes::Get(Floors::BottomFloor, Floors::TopFloor);
+  m_log.Trace("Travel times ready, bottom to top floor: " + std::to_string(expressRun.count()) + "ms", Log::TraceLevel::Verbose);
+
+  m_startTime = std::chrono::steady_clock::now();
+
+  if (Configuration::Passengers::Enabled)
+    m_passengers.Start();
+
+  if (Configuration::Reallocation::Enabled)
+  {
+    m_reallocationThread = std::make_unique<ReallocationThread>(this);
+    m_reallocationThread->Start();
+    m_reallocationThread->Go();
+  }
+
+  if (Configuration::WaitTimeSlo::Enabled)
+  {
+    m_sloMonitorThread = std::make_unique<SloMonitorThread>(this);
+    m_sloMonitorThread->Start();
+    m_sloMonitorThread->Go();
+  }
+
+  if (Configuration::Statistics::ReportPeriod.count() > 0)
+  {
+    m_reportThread = std::make_unique<ReportThread>(this);
+    m_reportThread->Start();
+    m_reportThread->Go();
+  }
+
+  Journal::Record(Journal::EventType::Started, Journal::NoElevator, Floors::InvalidFloor, 0, static_cast<int>(numberOfElevators));
 }
 
 Management::~Management()
@@ -30,9 +121,31 @@ void Management::Shutdown()
 
   m_log.Trace("Shutdown in progress...", Log::TraceLevel::Verbose);
 
+  {
+    // No more assignments after this point: the elevators can be stopped without holding the lock
+    std::lock_guard<InstrumentedMutex> lock(m_mutex);
+    m_shutdownRequested = true;
+
+    if (!m_pendingCalls.empty())
+      m_log.Trace("Calls never assigned: " + std::to_string(m_pendingCalls.size()), Log::TraceLevel::Warning);
+  }
+
+  m_passengers.Stop();
+
+  if (m_reallocationThread != nullptr)
+    m_reallocationThread->Stop();
+
+  if (m_sloMonitorThread != nullptr)
+    m_sloMonitorThread->Stop();
+
+  if (m_reportThread != nullptr)
+    m_reportThread->Stop();
+
   for (auto& elevator : m_elevators)
     elevator->ShutDown();
 
+  TraceStatistics();
+
   m_elevators.clear();
 
   m_log.Trace("Shutdown completed", Log::TraceLevel::Verbose);
@@ -40,39 +153,730 @@ void Management::Shutdown()
 
 bool Management::AssignCall(std::shared_ptr<Call>& call)
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return false;
+
+  return Assign(call);
+}
+
+std::size_t Management::AssignCalls(std::vector<std::shared_ptr<Call>>& calls)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return 0;
+
+  std::size_t callsAssigned = 0;
+
+  for (auto& call : calls)
+  {
+    if (Assign(call, true, false))
+      ++callsAssigned;
+  }
+
+  m_log.Trace("Batch of " + std::to_string(calls.size()) + " calls, assigned: " + std::to_string(callsAssigned));
+
+  return callsAssigned;
+}
+
+/**
+ * \brief Choose the elevator for a call. Called with the lock held.
+ */
+bool Management::Assign(std::shared_ptr<Call>& call, const bool isNewDemand, const bool traceCall)
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
   bool callAssigned = false;
 
-  const auto assignCall = [&call, this](const auto& elevator)
+  const auto serves = [&call](const auto& elevator) { return elevator->Serves(call); };
+  const auto servesFloor = [](const Floors::FloorNumber floor) { return [floor](const auto& elevator) { return elevator->Serves(floor); }; };
+
+  // Not even with a transfer at the lobby: the call would stay pending forever
+  if (std::none_of(m_elevators.begin(), m_elevators.end(), servesFloor(call->GetStartFloor()))
+    || std::none_of(m_elevators.begin(), m_elevators.end(), servesFloor(call->GetDestinationFloor())))
+  {
+    m_log.Trace("Call " + call->ToString() + " rejected, no elevator serves its floors", Log::TraceLevel::Error);
+
+    auto& waitingPeople = Floors::GetPeople();
+
+    if (waitingPeople.Abandon(call, call->GetCallTime()))
+      waitingPeople.Remove(call);
+
+    return false;
+  }
+
+  // A call moved from a failed elevator is not a new demand
+  if (isNewDemand && !call->IsRedispatched())
+    m_demandForecast.Record(*call);
+
+  // No zone serves both floors, so neither is the lobby: the person changes elevator there
+  if (std::none_of(m_elevators.begin(), m_elevators.end(), serves))
+  {
+    call->SetTransferFloor(Floors::Lobby);
+
+    if (traceCall)
+      m_log.Trace("Call " + call->ToString() + " transfer at the lobby");
+  }
+
+  // The person waits, and can lose patience, for the assigned elevator or for a pending assignment
+  m_passengers.Wait(call);
+
+  // Evaluated on the table: the available elevator with the lowest estimated time
+  auto best = m_table.Best(call->GetStartFloor(), call->GetDestinationFloor());
+
+  // A single elevator takes every call it serves, even if not available now
+  if (best < 0 && m_elevators.size() == 1 && serves(m_elevators.front()))
+    best = 0;
+
+  if (best >= 0)
+  {
+    AssignTo(*m_elevators[best], call, traceCall);
+    callAssigned = true;
+  }
+  else
+  {
+    // Assigning it to a busy elevator would make the person wait for a whole run: it waits for the first available one
+    if (traceCall)
+      m_log.Trace("Call " + call->ToString() + " pending, no elevator available", Log::TraceLevel::Verbose);
+
+    m_pendingCalls.push_back(call);
+    m_numberOfPendingCalls = m_pendingCalls.size();
+
+    Metrics::Increment(Metrics::Get().m_callsDeferred);
+    Metrics::Set(Metrics::Get().m_callsPending, static_cast<std::int64_t>(m_pendingCalls.size()));
+  }
+
+  return callAssigned;
+}
+
+void Management::AssignTo(Elevator& elevator, const std::shared_ptr<Call>& call, const bool traceCall)
+{
+  if (traceCall)
   {
     std::stringstream message;
-    message << "Call " << call->ToString() << " assigned to elevator: " << elevator->GetId();
+    message << "Call " << call->ToString() << " assigned to elevator: " << elevator.GetId();
     m_log.Trace(message);
+  }
 
-    call->SetAssignedElevator(elevator->GetId());
-    elevator->AnswerToCall(call);
-  };
+  m_parkingFloors.erase(elevator.GetId());
+  elevator.AnswerToCall(call);
 
-  const auto floorDifference = [&call](const auto& elevator) { return std::abs(static_cast<int>(elevator->GetCurrentFloor() - call->GetStartFloor())); };
+  Journal::Record(Journal::EventType::CallAssigned, elevator.GetIndex(), call->GetStartFloor(), call->GetId());
+  TraceEvents::Instant("Call assigned", elevator.GetIndex(), call->GetStartFloor(), call->GetId());
 
-  std::sort(m_elevators.begin(), m_elevators.end(),
-    [&floorDifference](const auto& a, const auto& b) { return floorDifference(a) > floorDifference(b); });
+  Metrics::Increment(Metrics::Get().m_callsAssigned);
+}
+
+/**
+ * \brief Assign the pending calls, oldest first, to the elevators available now. Called by the elevators
+ * when they become available: nothing to do, without locking, if no call is pending.
+ */
+void Management::AssignPending()
+{
+  if (m_numberOfPendingCalls == 0)
+    return;
+
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return;
 
-  for(auto& elevator : m_elevators)
+  for (auto call = m_pendingCalls.begin(); call != m_pendingCalls.end();)
   {
-    if ( m_elevators.size() == 1 || elevator->Available(call))
+    // Abandoned while pending: no elevator will reap it from the waiting people
+    if ((*call)->GetState() != Call::State::Waiting)
     {
-      assignCall(elevator);
-      callAssigned = true;
-      break;
+      Floors::GetPeople().Remove(*call);
+      call = m_pendingCalls.erase(call);
+      continue;
     }
+
+    const auto best = m_table.Best((*call)->GetStartFloor(), (*call)->GetDestinationFloor());
+
+    if (best < 0)
+    {
+      ++call;
+      continue;
+    }
+
+    const auto pendingTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - (*call)->GetCallTime());
+    m_log.Trace("Pending call " + (*call)->ToString() + " assigned after " + std::to_string(pendingTime.count()) + "ms", Log::TraceLevel::Verbose);
+
+    AssignTo(*m_elevators[best], *call);
+    call = m_pendingCalls.erase(call);
   }
 
-  if (!callAssigned)
+  m_numberOfPendingCalls = m_pendingCalls.size();
+  Metrics::Set(Metrics::Get().m_callsPending, static_cast<std::int64_t>(m_pendingCalls.size()));
+}
+
+/**
+ * \brief Get the elevators, in index order: the index of an elevator is its lane in the table.
+ */
+std::vector<Elevator*> Management::GetElevators()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  std::vector<Elevator*> elevators;
+
+  for (const auto& elevator : m_elevators)
+    elevators.push_back(elevator.get());
+
+  return elevators;
+}
+
+void Management::Pause()
+{
+  // Without the lock: an elevator may need it (transfers, parking) to reach the pause
+  for (auto elevator : GetElevators())
+    elevator->Pause();
+}
+
+void Management::Resume()
+{
+  for (auto elevator : GetElevators())
+    elevator->Resume();
+}
+
+void Management::Serialize(CheckpointWriter& writer)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  writer.Write(m_startTime);
+  m_demandForecast.Serialize(writer);
+
+  writer.Write(static_cast<std::uint32_t>(m_parkingFloors.size()));
+
+  for (const auto& parking : m_parkingFloors)
   {
-    m_log.Trace("FORCED ASSIGNATION FOR CALL " + call->ToString(), Log::TraceLevel::Warning);
-   assignCall(*m_elevators.begin());
+    writer.Write(parking.first);
+    writer.Write(parking.second);
   }
 
-  return callAssigned;
+  writer.Write(static_cast<std::uint32_t>(m_elevators.size()));
+
+  for (const auto& elevator : m_elevators)
+  {
+    writer.Write(elevator->GetId());
+    elevator->Serialize(writer);
+  }
+
+  Floors::GetPeople().Serialize(writer);
+}
+
+/**
+ * \brief Read the state written by Serialize. The people waiting for a call not yet assigned
+ * when the checkpoint was written are assigned again.
+ */
+bool Management::Deserialize(CheckpointReader& reader)
+{
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+    std::uint32_t count = 0;
+
+    if (!reader.Read(m_startTime) || !m_demandForecast.Deserialize(reader) || !reader.Read(count))
+      return false;
+
+    m_parkingFloors.clear();
+
+    // The unassigned people restored are assigned again below
+    m_pendingCalls.clear();
+    m_numberOfPendingCalls = 0;
+
+    for (std::uint32_t index = 0; index < count; ++index)
+    {
+      std::string id;
+      unsigned int floor = 0;
+
+      if (!reader.Read(id) || !reader.Read(floor))
+        return false;
+
+      m_parkingFloors[id] = floor;
+    }
+
+    if (!reader.Read(count) || count != m_elevators.size())
+    {
+      m_log.Trace("Checkpoint error: different number of elevators", Log::TraceLevel::Error);
+      return false;
+    }
+
+    for (std::uint32_t index = 0; index < count; ++index)
+    {
+      std::string id;
+
+      if (!reader.Read(id))
+        return false;
+
+      const auto elevator = std::find_if(m_elevators.begin(), m_elevators.end(), [&id](const auto& candidate) { return candidate->GetId() == id; });
+
+      if (elevator == m_elevators.end() || !(*elevator)->Deserialize(reader))
+      {
+        m_log.Trace("Checkpoint error: cannot restore elevator " + id, Log::TraceLevel::Error);
+        return false;
+      }
+    }
+  }
+
+  auto& waitingPeople = Floors::GetPeople();
+
+  if (!waitingPeople.Deserialize(reader))
+    return false;
+
+  // The passengers scheduler and the management threads are not paused: the list is read with its lock
+  std::vector<std::shared_ptr<Call>> unassigned;
+
+  waitingPeople.Visit([&unassigned](const std::shared_ptr<Call>& person)
+  {
+    if (person->GetAssignedElevator() == "?")
+      unassigned.push_back(person);
+  });
+
+  {
+    std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+    // Already counted in the demand forecast restored above
+    for (auto& call : unassigned)
+      Assign(call, false);
+  }
+
+  waitingPeople.Trace();
+  return true;
+}
+
+/**
+ * \brief Assign the zones to the elevators, in order. Elevators exceeding the zones serve the whole building.
+ */
+void Management::SetZones()
+{
+  auto elevator = m_elevators.begin();
+
+  for (const auto& zone : Configuration::Building::Zones)
+  {
+    const auto lowestFloor = zone.m_lowestFloor < Floors::TopFloor ? zone.m_lowestFloor : Floors::TopFloor;
+    const auto highestFloor = zone.m_highestFloor < Floors::TopFloor ? zone.m_highestFloor : Floors::TopFloor;
+
+    for (auto count = 0U; count < zone.m_numberOfElevators && elevator != m_elevators.end(); ++count, ++elevator)
+      (*elevator)->SetZone(lowestFloor, highestFloor);
+  }
+
+  // Fewer elevators than the zones need: the calls from or to the floors left are rejected
+  for (auto floor = Floors::BottomFloor; floor <= Floors::TopFloor; ++floor)
+  {
+    if (std::none_of(m_elevators.begin(), m_elevators.end(), [floor](const auto& zoned) { return zoned->Serves(floor); }))
+      m_log.Trace("Floor " + std::to_string(floor) + " is not served by any elevator", Log::TraceLevel::Error);
+  }
+}
+
+/**
+ * \brief Continue the journey of a person arrived on the transfer floor.
+ */
+void Management::Transfer(const std::shared_ptr<Call>& call)
+{
+  call->Transfer();
+  Journal::Record(Journal::EventType::CallTransferred, Journal::NoElevator, call->GetStartFloor(), call->GetId(), static_cast<int>(call->GetDestinationFloor()));
+
+  auto transferCall = *Floors::GetPeople().Insert(call);
+  AssignCall(transferCall);
+}
+
+/**
+ * \brief Estimated time to serve a call: the run to the call floor plus a stop for every person already inside.
+ */
+std::chrono::milliseconds Management::EstimatedTime(const Elevator& elevator, const Call& call)
+{
+  const auto stopTime = 2 * Configuration::Elevator::DoorsOperationTime + Configuration::Elevator::EnterAndExitTime;
+
+  return TravelTimes::Get(elevator.GetCurrentFloor(), call.GetStartFloor()) + elevator.GetLoad() * stopTime;
+}
+
+void Management::ReallocationThread::CycleFunction(Management* management)
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
+  if (management == nullptr)
+    return;
+
+  auto nextReallocation = std::chrono::steady_clock::now() + Configuration::Reallocation::Period;
+
+  while (WaitUntil(nextReallocation))
+  {
+    management->Reallocate();
+    nextReallocation += Configuration::Reallocation::Period;
+  }
+}
+
+/**
+ * \brief Move the waiting calls to an elevator that would serve them clearly sooner than the assigned one.
+ * The stops of both elevators change with the waiting people locked: nobody boards meanwhile.
+ */
+void Management::Reallocate()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested || m_elevators.size() < 2)
+    return;
+
+  std::size_t reallocated = 0;
+
+  Floors::GetPeople().Visit([this, &reallocated](const std::shared_ptr<Call>& call)
+  {
+    if (call->GetState() != Call::State::Waiting)
+      return;
+
+    const auto assigned = std::find_if(m_elevators.begin(), m_elevators.end(),
+      [&call](const auto& elevator) { return elevator->GetId() == call->GetAssignedElevator(); });
+
+    if (assigned == m_elevators.end())
+      return;
+
+    // The best available elevator, if it is not the assigned one
+    const auto bestIndex = m_table.Best(call->GetStartFloor(), call->GetDestinationFloor());
+
+    if (bestIndex < 0 || m_elevators[bestIndex] == *assigned)
+      return;
+
+    const auto& best = m_elevators[bestIndex];
+    const auto gain = EstimatedTime(**assigned, *call) - EstimatedTime(*best, *call);
+
+    if (gain < Configuration::Reallocation::MinGain)
+      return;
+
+    m_log.Trace("Call " + call->ToString() + " moved to elevator " + best->GetId() + ", " + std::to_string(gain.count()) + "ms sooner");
+
+    call->SetReallocated();
+    Reassign(**assigned, *best, call);
+
+    Metrics::Increment(Metrics::Get().m_callsReallocated);
+    Metrics::Increment(Metrics::Get().m_reallocationGainMilliseconds, static_cast<std::uint64_t>(gain.count()));
+    ++reallocated;
+  });
+
+  if (reallocated > 0)
+    m_log.Trace("Calls reallocated: " + std::to_string(reallocated), Log::TraceLevel::Verbose);
+}
+
+/**
+ * \brief Move a waiting call between two elevators. Called with the waiting people locked: nobody boards meanwhile.
+ */
+void Management::Reassign(Elevator& from, Elevator& to, const std::shared_ptr<Call>& call)
+{
+  from.WithdrawCall(call);
+  to.AnswerToCall(call);
+  m_parkingFloors.erase(to.GetId());
+
+  Journal::Record(Journal::EventType::CallReallocated, to.GetIndex(), call->GetStartFloor(), call->GetId(), static_cast<int>(from.GetIndex()));
 }
 
+void Management::SloMonitorThread::CycleFunction(Management* management)
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
+  if (management == nullptr)
+    return;
+
+  auto nextCheck = std::chrono::steady_clock::now() + Configuration::WaitTimeSlo::Period;
+
+  while (WaitUntil(nextCheck))
+  {
+    management->MonitorWaitTimes();
+    nextCheck += Configuration::WaitTimeSlo::Period;
+  }
+}
+
+/**
+ * \brief Escalate the calls waiting longer than the escalation time and count the ones beyond the maximum waiting time.
+ */
+void Management::MonitorWaitTimes()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return;
+
+  const auto now = std::chrono::steady_clock::now();
+  std::int64_t callsOverSlo = 0;
+
+  Floors::GetPeople().Visit([this, &now, &callsOverSlo](const std::shared_ptr<Call>& call)
+  {
+    if (call->GetState() != Call::State::Waiting)
+      return;
+
+    const auto waitTime = now - call->GetCallTime();
+
+    if (waitTime > Configuration::WaitTimeSlo::MaxWaitTime)
+      ++callsOverSlo;
+
+    if (waitTime > Configuration::WaitTimeSlo::EscalationTime && !call->IsEscalated() && Escalate(call))
+      Metrics::Increment(Metrics::Get().m_sloEscalations);
+  });
+
+  Metrics::Set(Metrics::Get().m_callsOverSlo, callsOverSlo);
+}
+
+/**
+ * \brief Serve a call sooner: the best available elevator takes it if better than the assigned one; with no elevator
+ * available, the nearest one in service adds the stop, even if it has to reverse its direction first.
+ * A pending call is always assigned, an assigned one is moved only if the assigned elevator is slower, full or out of order.
+ * \return 'true' if the call was moved or assigned.
+ */
+bool Management::Escalate(const std::shared_ptr<Call>& call)
+{
+  call->SetEscalated();
+
+  const auto best = m_table.Best(call->GetStartFloor(), call->GetDestinationFloor());
+  auto target = best >= 0 ? m_elevators[best].get() : GetNearestElevator(*call);
+
+  const auto assigned = std::find_if(m_elevators.begin(), m_elevators.end(),
+    [&call](const auto& elevator) { return elevator->GetId() == call->GetAssignedElevator(); });
+
+  if (target == nullptr || (assigned != m_elevators.end() && assigned->get() == target))
+    return false;
+
+  if (assigned != m_elevators.end())
+  {
+    const auto& current = **assigned;
+    const auto keep = !current.IsFull() && current.GetStatus() != ElevatorStatus::OutOfOrder
+      && EstimatedTime(current, *call) <= EstimatedTime(*target, *call);
+
+    if (keep)
+      return false;
+
+    m_log.Trace("Call " + call->ToString() + " waiting too long, moved to elevator " + target->GetId(), Log::TraceLevel::Warning);
+    Reassign(**assigned, *target, call);
+    return true;
+  }
+
+  const auto pending = std::find(m_pendingCalls.begin(), m_pendingCalls.end(), call);
+
+  if (pending != m_pendingCalls.end())
+  {
+    m_pendingCalls.erase(pending);
+    m_numberOfPendingCalls = m_pendingCalls.size();
+    Metrics::Set(Metrics::Get().m_callsPending, static_cast<std::int64_t>(m_pendingCalls.size()));
+  }
+
+  m_log.Trace("Call " + call->ToString() + " waiting too long, assigned to elevator " + target->GetId(), Log::TraceLevel::Warning);
+  AssignTo(*target, call);
+  return true;
+}
+
+/**
+ * \brief Elevator in service and not full, serving the call, with the shortest run to the call floor.
+ */
+Elevator* Management::GetNearestElevator(const Call& call)
+{
+  Elevator* nearest = nullptr;
+  auto nearestTime = std::chrono::milliseconds::max();
+
+  for (const auto& elevator : m_elevators)
+  {
+    if (!elevator->Serves(call.GetStartFloor()) || !elevator->Serves(call.GetDestinationFloor())
+      || elevator->IsFull() || elevator->GetStatus() == ElevatorStatus::OutOfOrder)
+      continue;
+
+    const auto time = TravelTimes::Get(elevator->GetCurrentFloor(), call.GetStartFloor());
+
+    if (time < nearestTime)
+    {
+      nearest = elevator.get();
+      nearestTime = time;
+    }
+  }
+
+  return nearest;
+}
+
+/**
+ * \brief An elevator failed: its floor calls and the people evacuated go to the other elevators.
+ */
+void Management::Failover(Elevator& elevator, std::vector<std::shared_ptr<Call>>& calls)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return;
+
+  // Under the lock: no call can be assigned to the failed elevator meanwhile
+  elevator.ReleaseCalls(calls);
+  m_parkingFloors.erase(elevator.GetId());
+
+  m_log.Trace("Elevator " + elevator.GetId() + " failed, calls to assign again: " + std::to_string(calls.size()), Log::TraceLevel::Warning);
+
+  for (auto& call : calls)
+  {
+    call->SetRedispatched();
+    Assign(call);
+  }
+
+  const auto failoverTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - elevator.GetFaultTime());
+
+  Metrics::Increment(Metrics::Get().m_callsRedispatched, calls.size());
+  Metrics::Set(Metrics::Get().m_lastFailoverMilliseconds, failoverTime.count());
+
+  m_log.Trace("Failover completed " + std::to_string(failoverTime.count()) + "ms after the fault", Log::TraceLevel::Warning);
+}
+
+bool Management::InjectFault(const std::string& elevatorId, const ElevatorFault fault)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  const auto elevator = std::find_if(m_elevators.begin(), m_elevators.end(), [&elevatorId](const auto& candidate) { return candidate->GetId() == elevatorId; });
+
+  if (elevator == m_elevators.end())
+    return false;
+
+  (*elevator)->InjectFault(fault);
+  return true;
+}
+
+/**
+ * \brief Choose the floor where an idle elevator waits for the next call, according to the parking policy.
+ */
+unsigned int Management::GetParkingFloor(const Elevator& elevator)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (m_shutdownRequested)
+    return elevator.GetCurrentFloor();
+
+  auto parkingFloor = elevator.Serves(elevator.GetHomeFloor()) ? elevator.GetHomeFloor() : Floors::Lobby;
+
+  if (Configuration::Parking::ParkingPolicy == Configuration::Parking::Policy::DemandWeighted)
+  {
+    // The served floor with the highest forecast of calls, not already chosen by another idle elevator
+    auto maxRate = 0.0;
+
+    for (Floors::FloorNumber floor = Floors::BottomFloor; Floors::IsValid(floor); ++floor)
+    {
+      const auto taken = std::any_of(m_parkingFloors.begin(), m_parkingFloors.end(),
+        [&elevator, floor](const auto& parking) { return parking.first != elevator.GetId() && parking.second == floor; });
+
+      if (taken || !elevator.Serves(floor))
+        continue;
+
+      const auto rate = m_demandForecast.GetRate(floor);
+
+      if (rate > maxRate)
+      {
+        maxRate = rate;
+        parkingFloor = floor;
+      }
+    }
+  }
+
+  m_parkingFloors[elevator.GetId()] = parkingFloor;
+
+  return parkingFloor;
+}
+
+/**
+ * \brief Trace the round trip time of every elevator and the handling capacity of the building.
+ */
+void Management::ReportThread::CycleFunction(Management* management)
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Management);
+
+  if (management == nullptr)
+    return;
+
+  auto nextReport = std::chrono::steady_clock::now() + Configuration::Statistics::ReportPeriod;
+
+  while (WaitUntil(nextReport))
+  {
+    management->ReportStatistics();
+    nextReport += Configuration::Statistics::ReportPeriod;
+  }
+}
+
+void Management::ReportStatistics()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (!m_shutdownRequested)
+    TraceStatistics();
+}
+
+/**
+ * \brief Write the statistics of every elevator, with the share of time in every status, and of the whole bank.
+ * Busy time is moving and loading people, over the time in service: an elevator far from the bank average is reported.
+ */
+void Management::TraceStatistics()
+{
+  const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - m_startTime);
+
+  const auto stateIndex = [](const ElevatorStatus status) { return static_cast<std::size_t>(static_cast<int>(status) + 1); };
+
+  std::vector<double> busyRatios;
+
+  for (const auto& elevator : m_elevators)
+  {
+    const auto times = elevator->GetStateTimes();
+    const auto inService = times[stateIndex(ElevatorStatus::Idle)] + times[stateIndex(ElevatorStatus::PeopleEnterAndExit)] + times[stateIndex(ElevatorStatus::Moving)];
+    const auto busy = times[stateIndex(ElevatorStatus::PeopleEnterAndExit)] + times[stateIndex(ElevatorStatus::Moving)];
+
+    busyRatios.push_back(inService.count() > 0 ? static_cast<double>(busy.count()) / inService.count() : 0.0);
+  }
+
+  const auto averageBusyRatio = busyRatios.empty() ? 0.0 : std::accumulate(busyRatios.begin(), busyRatios.end(), 0.0) / busyRatios.size();
+
+  unsigned int peopleDelivered = 0;
+
+  for (std::size_t index = 0; index < m_elevators.size(); ++index)
+  {
+    const auto& elevator = m_elevators[index];
+    const auto& statistics = elevator->GetStatistics();
+    const auto& metrics = Metrics::GetElevator(elevator->GetIndex());
+    const unsigned int delivered = statistics.m_peopleDelivered;
+    const unsigned int roundTrips = statistics.m_roundTrips;
+    peopleDelivered += delivered;
+
+    std::stringstream message;
+    message << "Floors " << elevator->GetLowestFloor() << "-" << elevator->GetHighestFloor()
+      << ", people delivered: " << delivered
+      << ", round trips: " << roundTrips;
+
+    if (roundTrips > 0)
+      message << ", average round trip time: " << statistics.m_roundTripsMilliseconds / roundTrips << "ms";
+
+    m_log.Trace(message, Log::TraceLevel::Info, elevator->GetElevatorName());
+
+    const auto times = elevator->GetStateTimes();
+    const auto total = std::accumulate(times.begin(), times.end(), std::chrono::milliseconds::zero());
+    const auto share = [&times, &total, &stateIndex](const ElevatorStatus status)
+      { return total.count() > 0 ? times[stateIndex(status)].count() * 100 / total.count() : 0; };
+
+    std::stringstream usage;
+    usage << "Moving " << share(ElevatorStatus::Moving) << "%, loading " << share(ElevatorStatus::PeopleEnterAndExit)
+      << "%, idle " << share(ElevatorStatus::Idle) << "%, out of order " << share(ElevatorStatus::OutOfOrder) << "%"
+      << ", floors travelled: " << metrics.m_floorsTravelled.load(std::memory_order_relaxed)
+      << ", stops: " << metrics.m_stopsMade.load(std::memory_order_relaxed)
+      << ", door cycles: " << metrics.m_doorCycles.load(std::memory_order_relaxed)
+      << ", people carried: " << metrics.m_peopleBoarded.load(std::memory_order_relaxed);
+
+    if (m_elevators.size() > 1 && averageBusyRatio > 0.0)
+    {
+      if (busyRatios[index] > averageBusyRatio * Configuration::Statistics::ImbalanceFactor)
+        usage << " - OVERLOADED";
+      else if (busyRatios[index] * Configuration::Statistics::ImbalanceFactor < averageBusyRatio)
+        usage << " - UNDERUSED";
+    }
+
+    m_log.Trace(usage, Log::TraceLevel::Info, elevator->GetElevatorName());
+  }
+
+  std::stringstream message;
+  message << (Configuration::Building::Zoning ? "Zoning" : "No zoning")
+    << ", people delivered: " << peopleDelivered << " in " << elapsed.count() << "s";
+
+  if (elapsed.count() > 0)
+    message << ", handling capacity: " << peopleDelivered * 300U / elapsed.count() << " people / 5 minutes";
+
+  m_log.Trace(message);
+}
@@ -8,12 +8,61 @@
 #pragma once
 
 #include "Log.h"
+#include "DemandForecast.h"
+#include "Passengers.h"
+#include "ElevatorTable.h"
+#include "WorkerThread.h"
+#include "LockStats.h"
 
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <deque>
+#include <string>
+
+enum class ElevatorFault;
 
 class Management final 
 {
+private:
+  /**
+   * \brief Runs the reallocation pass every Configuration::Reallocation::Period.
+   */
+  class ReallocationThread final : public WorkerThread<Management>
+  {
+  public:
+    explicit ReallocationThread(Management* management) : WorkerThread<Management>(management) {}
+
+  protected:
+    void CycleFunction(Management* management) override;
+  };
+
+  /**
+   * \brief Checks the waiting times every Configuration::WaitTimeSlo::Period.
+   */
+  class SloMonitorThread final : public WorkerThread<Management>
+  {
+  public:
+    explicit SloMonitorThread(Management* management) : WorkerThread<Management>(management) {}
+
+  protected:
+    void CycleFunction(Management* management) override;
+  };
+
+  /**
+   * \brief Writes the statistics of the elevators every Configuration::Statistics::ReportPeriod.
+   */
+  class ReportThread final : public WorkerThread<Management>
+  {
+  public:
+    explicit ReportThread(Management* management) : WorkerThread<Management>(management) {}
+
+  protected:
+    void CycleFunction(Management* management) override;
+  };
+
 public:
   explicit Management(const unsigned int numberOfElevators);
 
@@ -28,10 +77,78 @@ public:
 public:
   bool AssignCall(class std::shared_ptr<class Call>& call);
 
+  /**
+   * \brief Assign a batch of calls with a single lock, tracing the batch instead of every call.
+   * \return Number of calls assigned, the others are pending.
+   */
+  std::size_t AssignCalls(std::vector<std::shared_ptr<class Call>>& calls);
+
+  /**
+   * \brief Inject a fault in an elevator, see ElevatorFault.
+   * \return 'false' if the elevator does not exist.
+   */
+  bool InjectFault(const std::string& elevatorId, const ElevatorFault fault);
+
   void Shutdown();
 
+  /**
+   * \brief Pause and resume all the elevators. See Elevator::Pause.
+   */
+  void Pause();
+  void Resume();
+
+  /**
+   * \brief Write and read the dispatcher state, the elevators and the waiting people. The elevators must be paused.
+   */
+  void Serialize(class CheckpointWriter& writer);
+  bool Deserialize(class CheckpointReader& reader);
+
 private:
+  std::vector<class Elevator*> GetElevators();
+
+  /**
+   * \brief Choose the elevator for a call. Called with the lock held.
+   * \param isNewDemand 'false' for a call already counted in the demand forecast, as the restored ones.
+   * \param traceCall 'false' in a batch, traced as a whole: no message is built per call.
+   */
+  bool Assign(std::shared_ptr<class Call>& call, const bool isNewDemand = true, const bool traceCall = true);
+  void AssignTo(class Elevator& elevator, const std::shared_ptr<class Call>& call, const bool traceCall = true);
+  void AssignPending();
+  void Reallocate();
+  void Reassign(class Elevator& from, class Elevator& to, const std::shared_ptr<class Call>& call);
+  void MonitorWaitTimes();
+  bool Escalate(const std::shared_ptr<class Call>& call);
+  class Elevator* GetNearestElevator(const class Call& call);
+
+  static std::chrono::milliseconds EstimatedTime(const class Elevator& elevator, const class Call& call);
+
+  void SetZones();
+  void Transfer(const std::shared_ptr<class Call>& call);
+  void Failover(class Elevator& elevator, std::vector<std::shared_ptr<class Call>>& calls);
+  unsigned int GetParkingFloor(const class Elevator& elevator);
+
+  void ReportStatistics();
+  void TraceStatistics();
+
+private:
+  ElevatorTable m_table;  // before the elevators, that write it until they are destroyed
   std::vector<std::unique_ptr<class Elevator>> m_elevators;
 
+  InstrumentedMutex m_mutex{ "Management" };
+  std::atomic_bool m_shutdownRequested{ false };
+
+  DemandForecast m_demandForecast;
+  Passengers m_passengers{ *this };
+  std::unique_ptr<WorkerThread<Management>> m_reallocationThread;
+  std::unique_ptr<WorkerThread<Management>> m_sloMonitorThread;
+  std::unique_ptr<WorkerThread<Management>> m_reportThread;
+  std::map<std::string, unsigned int> m_parkingFloors;
+
+  // Calls no elevator could take yet, oldest first: assigned when an elevator becomes available
+  std::deque<std::shared_ptr<class Call>> m_pendingCalls;
+  std::atomic<std::size_t> m_numberOfPendingCalls{ 0 };
+
+  std::chrono::steady_clock::time_point m_startTime;
+
   Log m_log;
 };
@@ -0,0 +1,82 @@
+#include "Metrics.h"
+
+#include "SharedMemory.h"
+#include "Floors.h"
+#include "Configuration.h"
+
+#include <new>
+#include <chrono>
+
+const std::uint64_t Metrics::WaitTimeBounds[WaitTimeBuckets] = { 5000, 10000, 20000, 30000, 45000, 60000, 90000, 120000, 180000, 300000 };
+
+namespace
+{
+  bool published = false;  // written once by Open
+}
+
+Metrics::Segment& Metrics::Get()
+{
+  static Segment* const segment = Open();
+  return *segment;
+}
+
+bool Metrics::IsPublished()
+{
+  Get();
+  return published;
+}
+
+Metrics::ElevatorMetrics& Metrics::GetElevator(const unsigned int index)
+{
+  static ElevatorMetrics dummy;
+
+  return index < MaxElevators ? Get().m_elevators[index] : dummy;
+}
+
+Metrics::FloorMetrics& Metrics::GetFloor(const unsigned int floor)
+{
+  static FloorMetrics dummy;
+
+  return floor < MaxFloors ? Get().m_floors[floor] : dummy;
+}
+
+void Metrics::Observe(WaitTimeHistogram& histogram, const std::uint64_t milliseconds)
+{
+  unsigned int bucket = 0;
+
+  while (bucket < WaitTimeBuckets && milliseconds > WaitTimeBounds[bucket])
+    ++bucket;
+
+  Increment(histogram.m_buckets[bucket]);
+  Increment(histogram.m_sumMilliseconds, milliseconds);
+}
+
+Metrics::Segment* Metrics::Open()
+{
+  // Never destroyed: the metrics can be written until the very end of the process (e.g. by the log thread)
+  static auto sharedMemory = new SharedMemory();
+  static Segment localSegment;
+
+  void* address = &localSegment;
+
+  // Exclusive: opening the segment of a running instance would reset its counters below
+  if (Configuration::Metrics::PublishInSharedMemory && sharedMemory->Create(Configuration::Metrics::SegmentName, sizeof(Segment), true))
+  {
+    address = sharedMemory->GetAddress();
+    published = true;
+  }
+
+  auto segment = new (address) Segment();
+
+  segment->m_version = Version;
+  segment->m_numberOfFloors = Floors::TotalFloors;
+  segment->m_numberOfElevators = Configuration::Building::NumberOfElevators;
+  segment->m_startTime = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+
+  // The magic number is written last: a reader seeing it sees a complete header
+  std::atomic_thread_fence(std::memory_order_release);
+  segment->m_magic = Magic;
+
+  return segment;
+}
@@ -0,0 +1,160 @@
+/**********************************************************************************
+*        File: Metrics.h
+* Description: Live counters and gauges published in a shared memory segment.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The segment layout is fixed: external readers map the segment and
+*              read the values without any lock.
+**********************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Metrics require lock-free 64 bit atomics");
+
+/**
+ * \brief Live metrics of the simulation. Every update costs a relaxed atomic store.
+ */
+class Metrics final
+{
+public:
+  typedef std::atomic<std::uint64_t> Counter;
+  typedef std::atomic<std::int64_t> Gauge;
+
+  static constexpr std::uint32_t Magic = 0x56454C45; // "ELEV"
+  static constexpr std::uint32_t Version = 11;
+  static constexpr unsigned int MaxElevators = 256;
+  static constexpr unsigned int MaxFloors = 256;
+
+  static constexpr unsigned int NumberOfStates = 4;  // ElevatorStatus values, OutOfOrder (-1) first
+
+  static constexpr unsigned int WaitTimeBuckets = 10;
+  static const std::uint64_t WaitTimeBounds[WaitTimeBuckets]; // upper bounds of the buckets, in milliseconds
+
+  /**
+   * \brief Histogram of the waiting times. Every bucket counts only its own observations
+   * (not cumulative), the last one counts the observations exceeding all the bounds.
+   */
+  struct WaitTimeHistogram
+  {
+    Counter m_buckets[WaitTimeBuckets + 1];
+    Counter m_sumMilliseconds;
+  };
+
+  /**
+   * \brief Metrics of a single elevator, written only by the elevator thread; except m_stops, written also
+   * by the management thread when a call is assigned or cancelled, always with the lock of the elevator Floors held.
+   */
+  struct ElevatorMetrics
+  {
+    Gauge m_floor;
+    Gauge m_direction;  // Direction values
+    Gauge m_status;     // ElevatorStatus values
+    Gauge m_load;
+    Counter m_peopleBoarded;
+    Counter m_peopleDelivered;
+    Gauge m_stops;  // bit n set if the elevator has to stop on the floor n (first 64 floors only), serialized by the Floors lock
+    Counter m_busyMilliseconds;  // time spent moving, operating the doors and loading people
+    Counter m_failures;          // out of service, or doors stuck beyond the failover timeout
+    Counter m_sloBreaches;       // people boarded after Configuration::WaitTimeSlo::MaxWaitTime
+    Counter m_stateMilliseconds[NumberOfStates];  // time in every status, up to the last change of status
+    Counter m_floorsTravelled;
+    Counter m_stopsMade;         // stops with the doors opened
+    Counter m_doorCycles;
+    WaitTimeHistogram m_waitTime;  // waiting time of the people who boarded
+    WaitTimeHistogram m_redispatchedWaitTime;  // calls moved from a failed elevator, included in m_waitTime
+    WaitTimeHistogram m_reallocatedWaitTime;   // calls moved to an elevator serving them sooner, included in m_waitTime
+  };
+
+  /**
+   * \brief Metrics of a floor, written by all the elevators.
+   */
+  struct FloorMetrics
+  {
+    Gauge m_waiting[2];  // people waiting for the assigned elevator, per direction (Up, Down)
+  };
+
+  /**
+   * \brief Layout of the shared memory segment.
+   */
+  struct Segment
+  {
+    std::uint32_t m_magic;
+    std::uint32_t m_version;
+    std::uint32_t m_numberOfFloors;
+    std::uint32_t m_numberOfElevators;
+    std::uint64_t m_startTime;  // milliseconds since the epoch (system clock)
+
+    Counter m_callsGenerated;  // written by the calls generator
+    Counter m_callsAssigned;   // written by the management, under its lock
+    Gauge m_peopleWaiting;
+    Gauge m_logQueueDepth;
+    Counter m_logMessagesDropped;  // written under the log queue lock
+    Counter m_passengersGaveUp;    // written by the passengers scheduler
+    Counter m_passengersWalked;    // took the stairs, written by the passengers scheduler
+    Counter m_passengersReCalled;  // written by the passengers scheduler
+    Counter m_callsRedispatched;   // moved from a failed elevator, written under the management lock
+    Gauge m_lastFailoverMilliseconds;  // from the last fault to the end of its re-dispatch
+    Counter m_callsReallocated;            // written under the management lock
+    Counter m_reallocationGainMilliseconds;  // estimated time saved by the reallocations
+    Counter m_callsDeferred;   // no elevator available, written under the management lock
+    Gauge m_callsPending;      // deferred calls not assigned yet
+    Counter m_sloEscalations;  // written under the management lock
+    Gauge m_callsOverSlo;      // waiting longer than the maximum waiting time, at the last check of the monitor
+
+    ElevatorMetrics m_elevators[MaxElevators];
+    FloorMetrics m_floors[MaxFloors];
+  };
+
+public:
+  Metrics() = delete;
+
+  /**
+   * \brief Get the segment, creating it at the first use. If the shared memory is not
+   * available (or disabled in the configuration) a process local segment is used.
+   */
+  static Segment& Get();
+
+  /**
+   * \brief Indicates if the segment is in shared memory: not if disabled, or if another instance is publishing.
+   */
+  static bool IsPublished();
+
+  /**
+   * \brief Get the metrics of an elevator. Indexes exceeding MaxElevators share a dummy slot.
+   */
+  static ElevatorMetrics& GetElevator(const unsigned int index);
+
+  /**
+   * \brief Get the metrics of a floor. Floors exceeding MaxFloors share a dummy slot.
+   */
+  static FloorMetrics& GetFloor(const unsigned int floor);
+
+  /**
+   * \brief Increment a counter. Counters have a single writer (or writers serialized by a lock),
+   * so the increment is a relaxed load and store instead of a read-modify-write.
+   */
+  static void Increment(Counter& counter, const std::uint64_t value = 1U)
+    { counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed); }
+
+  /**
+   * \brief Set a gauge.
+   */
+  static void Set(Gauge& gauge, const std::int64_t value) { gauge.store(value, std::memory_order_relaxed); }
+
+  /**
+   * \brief Add to a gauge with many writers: a relaxed read-modify-write.
+   */
+  static void Add(Gauge& gauge, const std::int64_t value) { gauge.fetch_add(value, std::memory_order_relaxed); }
+
+  /**
+   * \brief Add an observation to a histogram. Same single writer rule of the counters.
+   * \param histogram Histogram to update.
+   * \param milliseconds Observed value.
+   */
+  static void Observe(WaitTimeHistogram& histogram, const std::uint64_t milliseconds);
+
+private:
+  static Segment* Open();
+};
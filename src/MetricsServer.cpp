@@ -0,0 +1,363 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+  constexpr long PollTimeoutMilliseconds = 250;   // how often the server thread checks the shutdown
+  constexpr std::size_t MaxRequestSize = 4096;
+
+#ifdef _WIN32
+  constexpr int SendFlags = 0;
+#else
+  constexpr int SendFlags = MSG_NOSIGNAL;
+#endif
+
+  std::uint64_t Read(const Metrics::Counter& counter) { return counter.load(std::memory_order_relaxed); }
+  std::int64_t Read(const Metrics::Gauge& gauge) { return gauge.load(std::memory_order_relaxed); }
+
+  void Header(std::ostringstream& text, const char* name, const char* type, const char* help)
+  {
+    text << "# HELP " << name << ' ' << help << '\n';
+    text << "# TYPE " << name << ' ' << type << '\n';
+  }
+
+  void Histogram(std::ostringstream& text, const char* name, const unsigned int index, const Metrics::WaitTimeHistogram& histogram)
+  {
+    const std::string elevator = std::string("elevator=\"") + static_cast<char>('A' + index) + "\"";
+
+    // The buckets are stored separately: the exposition format wants them cumulative
+    std::uint64_t cumulative = 0;
+
+    for (unsigned int bucket = 0; bucket < Metrics::WaitTimeBuckets; ++bucket)
+    {
+      cumulative += Read(histogram.m_buckets[bucket]);
+      text << name << "_bucket{" << elevator << ",le=\"" << static_cast<double>(Metrics::WaitTimeBounds[bucket]) / 1000.0 << "\"} " << cumulative << '\n';
+    }
+
+    cumulative += Read(histogram.m_buckets[Metrics::WaitTimeBuckets]);
+    text << name << "_bucket{" << elevator << ",le=\"+Inf\"} " << cumulative << '\n';
+    text << name << "_sum{" << elevator << "} " << static_cast<double>(Read(histogram.m_sumMilliseconds)) / 1000.0 << '\n';
+    text << name << "_count{" << elevator << "} " << cumulative << '\n';
+  }
+}
+
+MetricsServer::MetricsServer(const unsigned short port)
+{
+  m_log.SetTraceId("Metrics server");
+
+#ifdef _WIN32
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+  {
+    m_log.Trace("Winsock initialization failed", Log::TraceLevel::Error);
+    return;
+  }
+#endif
+
+  const auto listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+  if (static_cast<Socket>(listener) == InvalidSocket)
+  {
+    m_log.Trace("Cannot create the socket", Log::TraceLevel::Error);
+    return;
+  }
+
+  const int reuse = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+  if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0)
+  {
+    m_log.Trace("Cannot listen on port " + std::to_string(port), Log::TraceLevel::Error);
+    CloseSocket(static_cast<Socket>(listener));
+    return;
+  }
+
+  m_listener = static_cast<Socket>(listener);
+  m_log.Trace("Listening on http://127.0.0.1:" + std::to_string(port) + "/metrics");
+
+  m_thread = std::make_unique<std::thread>(&MetricsServer::ServerThreadFunction, this);
+}
+
+MetricsServer::~MetricsServer()
+{
+  Shutdown();
+}
+
+void MetricsServer::Shutdown()
+{
+  m_shutdownRequested = true;
+
+  if (m_thread != nullptr && m_thread->joinable())
+    m_thread->join();
+
+  m_thread.reset();
+
+  if (m_listener != InvalidSocket)
+  {
+    CloseSocket(m_listener);
+    m_listener = InvalidSocket;
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+  }
+}
+
+void MetricsServer::ServerThreadFunction()
+{
+  // No trace from here on: the scrapes must not contend the log queue
+  while (!m_shutdownRequested)
+  {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(m_listener, &readSet);
+
+    timeval timeout{ 0, PollTimeoutMilliseconds * 1000 };
+
+    if (select(static_cast<int>(m_listener + 1), &readSet, nullptr, nullptr, &timeout) <= 0)
+      continue;
+
+    const auto client = accept(m_listener, nullptr, nullptr);
+
+    if (static_cast<Socket>(client) == InvalidSocket)
+      continue;
+
+    Serve(static_cast<Socket>(client));
+    CloseSocket(static_cast<Socket>(client));
+  }
+}
+
+/**
+ * \brief Read the request line and answer: the body is sent only for GET /metrics.
+ */
+void MetricsServer::Serve(const Socket client) const
+{
+  std::string request;
+  char buffer[512];
+
+  while (request.find("\r\n\r\n") == std::string::npos && request.size() < MaxRequestSize && !m_shutdownRequested)
+  {
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(client, &readSet);
+
+    timeval timeout{ 0, PollTimeoutMilliseconds * 1000 };
+
+    if (select(static_cast<int>(client + 1), &readSet, nullptr, nullptr, &timeout) <= 0)
+      return;
+
+    const auto received = recv(client, buffer, sizeof(buffer), 0);
+
+    if (received <= 0)
+      return;
+
+    request.append(buffer, static_cast<std::size_t>(received));
+  }
+
+  std::string response;
+
+  if (request.compare(0, 13, "GET /metrics ") == 0)
+  {
+    const auto body = Exposition();
+    response = "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/plain; version=0.0.4\r\n"
+      "Content-Length: " + std::to_string(body.size()) + "\r\n"
+      "Connection: close\r\n\r\n" + body;
+  }
+  else
+  {
+    response = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+  }
+
+  std::size_t sent = 0;
+
+  while (sent < response.size())
+  {
+    const auto result = send(client, response.data() + sent, static_cast<int>(response.size() - sent), SendFlags);
+
+    if (result <= 0)
+      return;
+
+    sent += static_cast<std::size_t>(result);
+  }
+}
+
+/**
+ * \brief Build the text exposition of the metrics segment.
+ */
+std::string MetricsServer::Exposition()
+{
+  const auto& segment = Metrics::Get();
+  const auto numberOfElevators = segment.m_numberOfElevators < Metrics::MaxElevators ? segment.m_numberOfElevators : Metrics::MaxElevators;
+
+  const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+  const auto uptimeSeconds = now > segment.m_startTime ? static_cast<double>(now - segment.m_startTime) / 1000.0 : 0.0;
+
+  std::ostringstream text;
+
+  Header(text, "elevator_uptime_seconds", "gauge", "Time since the start of the simulation.");
+  text << "elevator_uptime_seconds " << uptimeSeconds << '\n';
+
+  Header(text, "elevator_calls_generated_total", "counter", "Calls generated.");
+  text << "elevator_calls_generated_total " << Read(segment.m_callsGenerated) << '\n';
+
+  Header(text, "elevator_calls_assigned_total", "counter", "Calls assigned to an elevator, transfers included.");
+  text << "elevator_calls_assigned_total " << Read(segment.m_callsAssigned) << '\n';
+
+  Header(text, "elevator_people_waiting", "gauge", "People waiting on the floors.");
+  text << "elevator_people_waiting " << Read(segment.m_peopleWaiting) << '\n';
+
+  Header(text, "elevator_log_queue_depth", "gauge", "Messages waiting in the log queue.");
+  text << "elevator_log_queue_depth " << Read(segment.m_logQueueDepth) << '\n';
+
+  Header(text, "elevator_log_messages_dropped_total", "counter", "Messages dropped because the log queue was full.");
+  text << "elevator_log_messages_dropped_total " << Read(segment.m_logMessagesDropped) << '\n';
+
+  Header(text, "elevator_passengers_gave_up_total", "counter", "Passengers left the floor after waiting too long.");
+  text << "elevator_passengers_gave_up_total " << Read(segment.m_passengersGaveUp) << '\n';
+
+  Header(text, "elevator_passengers_walked_total", "counter", "Passengers took the stairs after waiting too long.");
+  text << "elevator_passengers_walked_total " << Read(segment.m_passengersWalked) << '\n';
+
+  Header(text, "elevator_passengers_recalled_total", "counter", "Passengers called again after waiting too long.");
+  text << "elevator_passengers_recalled_total " << Read(segment.m_passengersReCalled) << '\n';
+
+  Header(text, "elevator_calls_redispatched_total", "counter", "Calls moved from a failed elevator to the others.");
+  text << "elevator_calls_redispatched_total " << Read(segment.m_callsRedispatched) << '\n';
+
+  Header(text, "elevator_last_failover_seconds", "gauge", "Time from the last fault to the end of the re-dispatch of its calls.");
+  text << "elevator_last_failover_seconds " << static_cast<double>(Read(segment.m_lastFailoverMilliseconds)) / 1000.0 << '\n';
+
+  Header(text, "elevator_calls_reallocated_total", "counter", "Waiting calls moved to an elevator serving them sooner.");
+  text << "elevator_calls_reallocated_total " << Read(segment.m_callsReallocated) << '\n';
+
+  Header(text, "elevator_reallocation_gain_seconds_total", "counter", "Estimated time saved by the reallocated calls.");
+  text << "elevator_reallocation_gain_seconds_total " << static_cast<double>(Read(segment.m_reallocationGainMilliseconds)) / 1000.0 << '\n';
+
+  Header(text, "elevator_calls_deferred_total", "counter", "Calls held back because no elevator was available.");
+  text << "elevator_calls_deferred_total " << Read(segment.m_callsDeferred) << '\n';
+
+  Header(text, "elevator_calls_pending", "gauge", "Deferred calls waiting for an available elevator.");
+  text << "elevator_calls_pending " << Read(segment.m_callsPending) << '\n';
+
+  Header(text, "elevator_slo_escalations_total", "counter", "Calls escalated for waiting close to the maximum waiting time.");
+  text << "elevator_slo_escalations_total " << Read(segment.m_sloEscalations) << '\n';
+
+  Header(text, "elevator_calls_over_slo", "gauge", "Calls waiting longer than the maximum waiting time.");
+  text << "elevator_calls_over_slo " << Read(segment.m_callsOverSlo) << '\n';
+
+  const auto label = [](const unsigned int index)
+  {
+    return std::string("{elevator=\"") + static_cast<char>('A' + index) + "\"}";
+  };
+
+  Header(text, "elevator_floor", "gauge", "Current floor of the elevator.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_floor" << label(index) << ' ' << Read(segment.m_elevators[index].m_floor) << '\n';
+
+  Header(text, "elevator_status", "gauge", "Status of the elevator (ElevatorStatus value).");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_status" << label(index) << ' ' << Read(segment.m_elevators[index].m_status) << '\n';
+
+  Header(text, "elevator_load", "gauge", "People inside the elevator.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_load" << label(index) << ' ' << Read(segment.m_elevators[index].m_load) << '\n';
+
+  Header(text, "elevator_people_boarded_total", "counter", "People entered in the elevator.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_people_boarded_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_peopleBoarded) << '\n';
+
+  Header(text, "elevator_people_delivered_total", "counter", "People delivered to their final destination.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_people_delivered_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_peopleDelivered) << '\n';
+
+  Header(text, "elevator_busy_seconds_total", "counter", "Time spent moving, operating the doors and loading people.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_busy_seconds_total" << label(index) << ' ' << static_cast<double>(Read(segment.m_elevators[index].m_busyMilliseconds)) / 1000.0 << '\n';
+
+  Header(text, "elevator_utilization_ratio", "gauge", "Busy time over uptime.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+  {
+    const auto busySeconds = static_cast<double>(Read(segment.m_elevators[index].m_busyMilliseconds)) / 1000.0;
+    text << "elevator_utilization_ratio" << label(index) << ' ' << (uptimeSeconds > 0.0 ? busySeconds / uptimeSeconds : 0.0) << '\n';
+  }
+
+  Header(text, "elevator_failures_total", "counter", "Times the elevator went out of service or had the doors stuck beyond the failover timeout.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_failures_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_failures) << '\n';
+
+  const char* const states[Metrics::NumberOfStates] = { "out_of_order", "idle", "loading", "moving" };
+
+  Header(text, "elevator_state_seconds_total", "counter", "Time spent in every status, up to the last change of status.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+  {
+    for (unsigned int state = 0; state < Metrics::NumberOfStates; ++state)
+    {
+      text << "elevator_state_seconds_total{elevator=\"" << static_cast<char>('A' + index) << "\",state=\"" << states[state] << "\"} "
+        << static_cast<double>(Read(segment.m_elevators[index].m_stateMilliseconds[state])) / 1000.0 << '\n';
+    }
+  }
+
+  Header(text, "elevator_floors_travelled_total", "counter", "Floors passed by the elevator.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_floors_travelled_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_floorsTravelled) << '\n';
+
+  Header(text, "elevator_stops_total", "counter", "Stops with the doors opened.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_stops_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_stopsMade) << '\n';
+
+  Header(text, "elevator_door_cycles_total", "counter", "Doors opened and closed.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_door_cycles_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_doorCycles) << '\n';
+
+  Header(text, "elevator_slo_breaches_total", "counter", "People boarded after the maximum waiting time.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    text << "elevator_slo_breaches_total" << label(index) << ' ' << Read(segment.m_elevators[index].m_sloBreaches) << '\n';
+
+  Header(text, "elevator_wait_seconds", "histogram", "Time from the floor call to the boarding.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    Histogram(text, "elevator_wait_seconds", index, segment.m_elevators[index].m_waitTime);
+
+  Header(text, "elevator_redispatched_wait_seconds", "histogram", "Time from the floor call to the boarding, calls moved from a failed elevator.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    Histogram(text, "elevator_redispatched_wait_seconds", index, segment.m_elevators[index].m_redispatchedWaitTime);
+
+  Header(text, "elevator_reallocated_wait_seconds", "histogram", "Time from the floor call to the boarding, calls moved to an elevator serving them sooner.");
+  for (unsigned int index = 0; index < numberOfElevators; ++index)
+    Histogram(text, "elevator_reallocated_wait_seconds", index, segment.m_elevators[index].m_reallocatedWaitTime);
+
+  return text.str();
+}
+
+void MetricsServer::CloseSocket(const Socket handle)
+{
+#ifdef _WIN32
+  closesocket(handle);
+#else
+  close(handle);
+#endif
+}
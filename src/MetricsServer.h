@@ -0,0 +1,65 @@
+/**********************************************************************************
+*        File: MetricsServer.h
+* Description: Minimal HTTP server exposing the live metrics in text exposition format.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: The server reads only the metrics segment: it shares no lock with the
+*              elevators, the management or the log.
+**********************************************************************************/
+
+#pragma once
+
+#include "Log.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+/**
+ * \brief Serves GET /metrics on the loopback interface, one request per connection, on its own thread.
+ */
+class MetricsServer final
+{
+public:
+  /**
+   * \brief Open the listening socket and start the server thread.
+   * \param port TCP port, bound to 127.0.0.1 only.
+   */
+  explicit MetricsServer(const unsigned short port);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer(MetricsServer&&) = delete;
+
+  MetricsServer& operator=(const MetricsServer&) = delete;
+  MetricsServer& operator=(MetricsServer&&) = delete;
+
+public:
+  void Shutdown();
+
+  bool IsListening() const { return m_listener != InvalidSocket; }
+
+private:
+#ifdef _WIN32
+  typedef std::uintptr_t Socket;
+  static constexpr Socket InvalidSocket = ~static_cast<Socket>(0);
+#else
+  typedef int Socket;
+  static constexpr Socket InvalidSocket = -1;
+#endif
+
+  void ServerThreadFunction();
+  void Serve(const Socket client) const;
+
+  static std::string Exposition();
+  static void CloseSocket(const Socket handle);
+
+private:
+  Socket m_listener = InvalidSocket;
+
+  std::unique_ptr<std::thread> m_thread;
+  std::atomic_bool m_shutdownRequested{ false };
+
+  Log m_log;
+};
@@ -0,0 +1,170 @@
+#include "Passengers.h"
+
+#include "Management.h"
+#include "Call.h"
+#include "Floors.h"
+#include "People.h"
+#include "Metrics.h"
+#include "Journal.h"
+#include "TraceEvents.h"
+#include "AllocStats.h"
+#include "Configuration.h"
+
+#include <functional>
+
+using namespace Configuration::Passengers;
+
+namespace
+{
+  enum class Choice { GiveUp, Walk, ReCall };
+}
+
+Passengers::Passengers(Management& management) :
+  m_management(management),
+  m_patienceEngine(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count())),
+  m_choiceEngine(m_patienceEngine())
+{
+  m_log.SetTraceId("Passengers");
+}
+
+Passengers::~Passengers()
+{
+  Stop();
+}
+
+void Passengers::Start()
+{
+  if (m_thread != nullptr)
+    return;
+
+  m_stopRequested = false;
+  m_thread = std::make_unique<std::thread>(&Passengers::SchedulerThreadFunction, this);
+}
+
+void Passengers::Stop()
+{
+  if (m_thread == nullptr)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopRequested = true;
+  }
+
+  m_wakeUp.notify_all();
+
+  if (m_thread->joinable())
+    m_thread->join();
+
+  m_thread.reset();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_agents = decltype(m_agents)();
+}
+
+void Passengers::Wait(const std::shared_ptr<Call>& call)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_thread == nullptr || m_stopRequested)
+    return;
+
+  std::uniform_int_distribution<long long> patience(MinPatience.count(), MaxPatience.count());
+  const auto deadline = call->GetCallTime() + std::chrono::milliseconds(patience(m_patienceEngine));
+
+  const auto earliest = m_agents.empty() || deadline < m_agents.top().m_deadline;
+  m_agents.push(Agent{ deadline, call->GetCallTime(), call });
+
+  if (earliest)
+    m_wakeUp.notify_one();
+}
+
+void Passengers::SchedulerThreadFunction()
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Generator);
+
+  std::vector<Agent> expired;
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (!m_stopRequested)
+  {
+    if (m_agents.empty())
+      m_wakeUp.wait(lock);
+    else
+      m_wakeUp.wait_until(lock, m_agents.top().m_deadline);
+
+    const auto now = std::chrono::steady_clock::now();
+
+    while (!m_agents.empty() && m_agents.top().m_deadline <= now)
+    {
+      expired.push_back(m_agents.top());
+      m_agents.pop();
+    }
+
+    if (expired.empty())
+      continue;
+
+    // No lock held while the passengers act: a call again takes the management lock
+    lock.unlock();
+
+    for (const auto& agent : expired)
+      Expire(agent);
+
+    expired.clear();
+    lock.lock();
+  }
+}
+
+/**
+ * \brief The patience of a passenger is over: if still on the floor, the passenger calls again or leaves.
+ */
+void Passengers::Expire(const Agent& agent)
+{
+  const auto& call = agent.m_call;
+  auto& waitingPeople = Floors::GetPeople();
+
+  if (!waitingPeople.Abandon(call, agent.m_callTime))
+    return; // already travelling, or transferred and waiting again
+
+  const auto startFloor = call->GetStartFloor();
+  const auto destinationFloor = call->GetFinalDestinationFloor();
+  const auto floors = startFloor > destinationFloor ? startFloor - destinationFloor : destinationFloor - startFloor;
+
+  std::bernoulli_distribution reCall(ReCallProbability);
+
+  auto choice = floors <= StairsMaxFloors ? Choice::Walk : Choice::GiveUp;
+
+  if (call->GetReCalls() < MaxReCalls && reCall(m_choiceEngine))
+    choice = Choice::ReCall;
+
+  Journal::Record(Journal::EventType::CallAbandoned, Journal::NoElevator, startFloor, call->GetId(), static_cast<int>(choice));
+
+  switch (choice)
+  {
+  case Choice::ReCall:
+  {
+    auto newCall = std::make_shared<Call>(startFloor, destinationFloor);
+    newCall->SetReCalls(call->GetReCalls() + 1);
+
+    m_log.Trace("Call " + call->ToString() + " abandoned, calling again", Log::TraceLevel::Verbose);
+    Metrics::Increment(Metrics::Get().m_passengersReCalled);
+
+    waitingPeople.Insert(newCall);
+    Journal::Record(Journal::EventType::CallCreated, Journal::NoElevator, startFloor, newCall->GetId(), static_cast<int>(destinationFloor));
+    TraceEvents::Instant("Call created", TraceEvents::NoElevator, startFloor, newCall->GetId());
+
+    m_management.AssignCall(newCall);
+    break;
+  }
+
+  case Choice::Walk:
+    m_log.Trace("Call " + call->ToString() + " abandoned, taking the stairs", Log::TraceLevel::Verbose);
+    Metrics::Increment(Metrics::Get().m_passengersWalked);
+    break;
+
+  case Choice::GiveUp:
+  default:
+    m_log.Trace("Call " + call->ToString() + " abandoned, giving up", Log::TraceLevel::Verbose);
+    Metrics::Increment(Metrics::Get().m_passengersGaveUp);
+  }
+}
@@ -0,0 +1,76 @@
+/**********************************************************************************
+*        File: Passengers.h
+* Description: Patience of the waiting passengers: calling again, taking the stairs, giving up.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: Every waiting passenger is an agent of a few bytes in a heap ordered by
+*              deadline, woken by a single scheduler thread.
+**********************************************************************************/
+
+#pragma once
+
+#include "Log.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Schedules the end of the patience of every waiting passenger.
+ *
+ * When the patience ends and the passenger is still on the floor, the passenger either calls again
+ * (a new call, dispatched by the management) or leaves, walking if the trip is short. The abandoned
+ * call stays pending for the assigned elevator, which finds nobody on the floor.
+ */
+class Passengers final
+{
+public:
+  explicit Passengers(class Management& management);
+  ~Passengers();
+
+  Passengers(const Passengers&) = delete;
+  Passengers(Passengers&&) = delete;
+
+  Passengers& operator=(const Passengers&) = delete;
+  Passengers& operator=(Passengers&&) = delete;
+
+public:
+  void Start();
+  void Stop();
+
+  /**
+   * \brief A passenger starts waiting for the elevator assigned to the call. Does nothing if not started.
+   */
+  void Wait(const std::shared_ptr<class Call>& call);
+
+private:
+  struct Agent
+  {
+    std::chrono::steady_clock::time_point m_deadline;
+    std::chrono::steady_clock::time_point m_callTime;  // identifies the wait, a transfer starts a new one
+    std::shared_ptr<class Call> m_call;
+
+    bool operator>(const Agent& other) const { return m_deadline > other.m_deadline; }
+  };
+
+  void SchedulerThreadFunction();
+  void Expire(const Agent& agent);
+
+private:
+  class Management& m_management;
+
+  std::priority_queue<Agent, std::vector<Agent>, std::greater<Agent>> m_agents;
+  std::default_random_engine m_patienceEngine;  // used under the lock
+  std::default_random_engine m_choiceEngine;    // used by the scheduler thread only
+
+  std::unique_ptr<std::thread> m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_wakeUp;
+  bool m_stopRequested = false;
+
+  Log m_log;
+};
@@ -2,26 +2,137 @@
 #include "Log.h"
 
 #include <sstream>
+#include <algorithm>
 
-void People::EnterAndExit(
+/**
+ * \brief People exit and then, up to the capacity, enter. Every person entering or exiting updates the stops.
+ * \param entered [Output] People entered on the current floor.
+ * \param exited [Output] People exited on the current floor.
+ * \return Number of people left on the floor because the elevator is full.
+ */
+std::size_t People::EnterAndExit(
   People& waitingPeople, 
+  Floors& stops,
   const Floors::FloorNumber currentFloor, 
   const Direction currentDirection, 
-  const std::string& elevatorId)
+  const std::string& elevatorId,
+  const std::size_t capacity,
+  std::list<std::shared_ptr<Call>>& entered,
+  std::list<std::shared_ptr<Call>>& exited)
 {
   waitingPeople.Trace(currentFloor);
-  Enter(waitingPeople, currentFloor, currentDirection, elevatorId);
-  Exit(currentFloor);
+  Exit(stops, currentFloor, exited);
+  return Enter(waitingPeople, stops, currentFloor, currentDirection, elevatorId, capacity, entered);
 }
 
 std::list<std::shared_ptr<Call>>::iterator People::Insert(const std::shared_ptr<Call>& call)
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
 
   push_front(call);
+  PublishSize();
+
   return begin();
 }
 
+void People::Insert(const std::vector<std::shared_ptr<Call>>& calls)
+{
+  // In reverse, as inserted one by one: the last call first
+  std::list<std::shared_ptr<Call>> batch(calls.rbegin(), calls.rend());
+
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  splice(begin(), batch);
+  PublishSize();
+}
+
+bool People::Abandon(const std::shared_ptr<Call>& call, const std::chrono::steady_clock::time_point callTime)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (call->GetState() != Call::State::Waiting || call->GetCallTime() != callTime)
+    return false;
+
+  call->SetState(Call::State::Abandoned);
+  ++m_abandoned;
+  PublishSize();
+
+  return true;
+}
+
+void People::Unassign(const std::string& elevatorId, std::vector<std::shared_ptr<Call>>& calls)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  auto person = begin();
+
+  while (person != end())
+  {
+    if ((*person)->GetAssignedElevator() != elevatorId)
+    {
+      ++person;
+      continue;
+    }
+
+    if ((*person)->GetState() == Call::State::Abandoned)
+    {
+      --m_abandoned;
+      person = erase(person);
+      continue;
+    }
+
+    (*person)->SetAssignedElevator("?");
+    calls.push_back(*person);
+    ++person;
+  }
+
+  PublishSize();
+}
+
+bool People::Remove(const std::shared_ptr<Call>& call)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  if (call->GetState() != Call::State::Abandoned)
+    return false;
+
+  const auto person = std::find(begin(), end(), call);
+
+  if (person == end())
+    return false;
+
+  --m_abandoned;
+  erase(person);
+  PublishSize();
+
+  return true;
+}
+
+void People::Evacuate(const Floors::FloorNumber currentFloor, std::list<std::shared_ptr<Call>>& exited, std::vector<std::shared_ptr<Call>>& evacuated)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  for (const auto& person : *this)
+  {
+    if (person->GetDestinationFloor() == currentFloor)
+      exited.push_back(person);
+    else
+    {
+      person->Evacuate(currentFloor);
+      evacuated.push_back(person);
+    }
+  }
+
+  clear();
+}
+
+void People::Visit(const std::function<void(const std::shared_ptr<Call>& person)>& visitor)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  for (const auto& person : *this)
+    visitor(person);
+}
+
 void People::Trace(const Floors::FloorNumber currentFloor)
 {
   std::stringstream message;
@@ -30,7 +141,7 @@ void People::Trace(const Floors::FloorNumber currentFloor)
   {
     message << "People waiting on floor " << std::to_string(currentFloor) << ": ";
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<InstrumentedMutex> lock(m_mutex);
     for (const auto& person : *this)
       if ((*person).GetStartFloor() == currentFloor)
         message << (*person).ToString();
@@ -39,7 +150,7 @@ void People::Trace(const Floors::FloorNumber currentFloor)
   {
     message << "People waiting on floors: ";
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<InstrumentedMutex> lock(m_mutex);
     for (const auto& person : *this)
         message << (*person).ToString();
   }
@@ -47,32 +158,103 @@ void People::Trace(const Floors::FloorNumber currentFloor)
   m_log.Trace(message);
 }
 
+void People::Serialize(CheckpointWriter& writer)
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+
+  writer.Write(static_cast<std::uint32_t>(size()));
+
+  for (const auto& person : *this)
+    person->Serialize(writer);
+}
+
+/**
+ * \brief Replace the people with the ones read from a checkpoint.
+ */
+bool People::Deserialize(CheckpointReader& reader)
+{
+  std::uint32_t count = 0;
+
+  if (!reader.Read(count))
+    return false;
+
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  clear();
+  m_abandoned = 0;
+
+  for (std::uint32_t index = 0; index < count; ++index)
+  {
+    const auto person = Call::Deserialize(reader);
+
+    if (person == nullptr || !person->IsValid())
+      return false;
+
+    if (person->GetState() == Call::State::Abandoned)
+      ++m_abandoned;
+
+    push_back(person);
+  }
+
+  PublishSize();
+  return true;
+}
+
 bool People::Empty() 
 {
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
   return empty();
 }
 
-void People::Enter(
+std::size_t People::Size()
+{
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
+  return size();
+}
+
+std::size_t People::Enter(
   People& waitingPeople, 
+  Floors& stops,
   const Floors::FloorNumber currentFloor, 
   const Direction currentDirection, 
-  const std::string& elevatorId)
+  const std::string& elevatorId,
+  const std::size_t capacity,
+  std::list<std::shared_ptr<Call>>& entered)
 {
   std::stringstream message;
   message << "People enter from floor " << std::to_string(currentFloor) << ": ";
 
-  std::lock_guard<std::mutex> waitingPeopleLock(waitingPeople.m_mutex);
+  std::size_t leftBehind = 0;
+
+  std::lock_guard<InstrumentedMutex> waitingPeopleLock(waitingPeople.m_mutex);
   auto person = waitingPeople.begin();
 
   while (person != waitingPeople.end())
   {
     if ((*person)->GetStartFloor() == currentFloor && (*person)->GetDirection() == currentDirection && (*person)->GetAssignedElevator() == elevatorId)
     {
-      message << (*person)->ToString();
+      if ((*person)->GetState() == Call::State::Abandoned)
+      {
+        stops.CallCancelled(*person);
+        --waitingPeople.m_abandoned;
+
+        person = waitingPeople.erase(person);
+        continue;
+      }
+
+      std::lock_guard<InstrumentedMutex> lock(m_mutex);
 
-      std::lock_guard<std::mutex> lock(m_mutex);
+      if (size() >= capacity)
+      {
+        ++leftBehind;
+        ++person;
+        continue;
+      }
+
+      message << (*person)->ToString();
+      (*person)->SetState(Call::State::Travelling);
       push_front(*person);
+      stops.PersonEntered(*person);
+      entered.push_back(*person);
 
       person = waitingPeople.erase(person);
       continue;
@@ -81,15 +263,22 @@ void People::Enter(
     ++person;
   }
 
+  waitingPeople.PublishSize();
+
+  if (leftBehind > 0)
+    message << " (" << leftBehind << " left on the floor, elevator full)";
+
   m_log.Trace(message);
+
+  return leftBehind;
 }
 
-void People::Exit(const Floors::FloorNumber currentFloor)
+void People::Exit(Floors& stops, const Floors::FloorNumber currentFloor, std::list<std::shared_ptr<Call>>& exited)
 {
   std::stringstream message;
   message << "People exit to floor " << std::to_string(currentFloor) << ": ";
 
-  std::lock_guard<std::mutex> lock(m_mutex);
+  std::lock_guard<InstrumentedMutex> lock(m_mutex);
   auto person = begin();
 
   while(person != end())
@@ -97,6 +286,8 @@ void People::Exit(const Floors::FloorNumber currentFloor)
     if ((*person)->GetDestinationFloor() == currentFloor)
     {
       message << (*person)->ToString();
+      stops.PersonExited(*person);
+      exited.push_back(*person);
       person = erase(person);
       continue;
     }
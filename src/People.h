@@ -8,13 +8,18 @@
 #pragma once
 
 #include <list>
+#include <functional>
+#include <vector>
 
 #include "Call.h"
+#include "Metrics.h"
+#include "LockStats.h"
 
 class People final : std::list<std::shared_ptr<Call>> 
 {
 public:
-  explicit People(const std::string& id = "") { SetId(id); }
+  explicit People(const std::string& id = "", Metrics::Gauge* sizeGauge = nullptr, const char* lockName = "People")
+    : m_mutex(lockName), m_sizeGauge(sizeGauge) { SetId(id); }
   ~People() noexcept = default;
 
   People(const People&) = delete;
@@ -26,33 +31,86 @@ public:
 public:
   iterator Insert(const std::shared_ptr<Call>& call);
 
-  void EnterAndExit(
+  /**
+   * \brief Insert a batch of calls with a single lock: the list nodes are allocated before taking it.
+   */
+  void Insert(const std::vector<std::shared_ptr<Call>>& calls);
+
+  /**
+   * \brief The person leaves the floor. The call stays in the list, and in the stops of the assigned
+   *        elevator, until the elevator arrives and finds nobody.
+   * \param callTime Call time of the wait being abandoned: a call transferred meanwhile is not abandoned.
+   * \return 'false' if the person is not waiting anymore.
+   */
+  bool Abandon(const std::shared_ptr<Call>& call, const std::chrono::steady_clock::time_point callTime);
+
+  /**
+   * \brief Take back the calls assigned to an elevator: the waiting ones become unassigned, the abandoned ones are removed.
+   * \param calls [Output] Calls to assign again.
+   */
+  void Unassign(const std::string& elevatorId, std::vector<std::shared_ptr<Call>>& calls);
+
+  /**
+   * \brief Remove an abandoned call, not assigned to any elevator: no elevator will arrive to reap it.
+   * \return 'false' if the call is not in the list or not abandoned.
+   */
+  bool Remove(const std::shared_ptr<Call>& call);
+
+  /**
+   * \brief Everybody leaves the elevator on the current floor: the people not arrived call again from there.
+   * \param exited [Output] People arrived at the destination.
+   * \param evacuated [Output] People to assign again.
+   */
+  void Evacuate(const Floors::FloorNumber currentFloor, std::list<std::shared_ptr<Call>>& exited, std::vector<std::shared_ptr<Call>>& evacuated);
+
+  std::size_t EnterAndExit(
     People& waitingPeople, 
+    Floors& stops,
     const Floors::FloorNumber currentFloor, 
     const Direction currentDirection, 
-    const std::string& elevatorId);
+    const std::string& elevatorId,
+    const std::size_t capacity,
+    std::list<std::shared_ptr<Call>>& entered,
+    std::list<std::shared_ptr<Call>>& exited);
+
+  /**
+   * \brief Call the visitor for every person, with the lock held.
+   */
+  void Visit(const std::function<void(const std::shared_ptr<Call>& person)>& visitor);
 
   void Trace(const Floors::FloorNumber currentFloor = Floors::InvalidFloor);
 
   bool Empty();
+  std::size_t Size();
 
   void SetId(const std::string& id) { m_log.SetTraceId(id); }
   std::string GetId() const { return m_log.GetTraceId(); }
 
+  void Serialize(CheckpointWriter& writer);
+  bool Deserialize(CheckpointReader& reader);
+
   // Functions for range based loops support
   const std::list<std::shared_ptr<Call>>& GetList() const { return *this; }
 
 private:
-  void Enter(
+  std::size_t Enter(
     People& waitingPeople, 
+    Floors& stops,
     const Floors::FloorNumber currentFloor, 
     const Direction currentDirection, 
-    const std::string& elevatorId);
+    const std::string& elevatorId,
+    const std::size_t capacity,
+    std::list<std::shared_ptr<Call>>& entered);
 
-  void Exit(const Floors::FloorNumber currentFloor);
+  void Exit(Floors& stops, const Floors::FloorNumber currentFloor, std::list<std::shared_ptr<Call>>& exited);
+
+  void PublishSize() { if (m_sizeGauge != nullptr) Metrics::Set(*m_sizeGauge, static_cast<std::int64_t>(size() - m_abandoned)); }
 
 private:
-  std::mutex m_mutex;
+  InstrumentedMutex m_mutex;
+
+  Metrics::Gauge* m_sizeGauge = nullptr; // [Optional] published number of people
+  std::size_t m_abandoned = 0;            // abandoned calls still in the list
 
   Log m_log;
 };
@@ -5,19 +5,45 @@
 #include "Floors.h"
 #include "People.h"
 #include "Watchdog.h"
+#include "Metrics.h"
+#include "Checkpoint.h"
+#include "Journal.h"
+#include "TraceEvents.h"
+#include "AllocStats.h"
 #include "Configuration.h"
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #include <random>
 #include <chrono>
+#include <cstring>
 #include <future>
 #include <memory>
 #include <functional>
+#include <sstream>
 
 using namespace std::chrono_literals;
 using namespace Configuration::CallsGenerator;
 
+namespace
+{
+  constexpr std::size_t BatchHeaderSize = 2;
+  constexpr std::size_t CallRecordSize = 4;
+  constexpr std::size_t MaxBatchBytes = BatchHeaderSize + MaxBatchSize * CallRecordSize;
+
+  constexpr long PollTimeoutMilliseconds = 250; // how often the ingress thread checks the stop request
 
-PeopleCallsGenerator::PeopleCallsGenerator(Management& management) : m_management(management)
+  std::uint16_t ReadUInt16(const unsigned char* data) { return static_cast<std::uint16_t>(data[0] | data[1] << 8); }
+}
+
+PeopleCallsGenerator::PeopleCallsGenerator(Management& management) :
+  m_management(management),
+  m_randomEngine(static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count()))
 {
   m_log.SetTraceId("Generator");
 }
@@ -47,6 +73,16 @@ void PeopleCallsGenerator::StartFixed()
   m_generatorThread->Go();
 }
 
+void PeopleCallsGenerator::StartSocket(const std::string& path)
+{
+  if (m_generatorThread != nullptr && m_generatorThread->IsActive())
+    m_generatorThread->Stop();
+
+  m_generatorThread = std::make_unique<SocketIngressThread>(this, path);
+  m_generatorThread->Start();
+  m_generatorThread->Go();
+}
+
 void PeopleCallsGenerator::Shutdown()
 {
   if (m_generatorThread == nullptr)
@@ -58,17 +94,38 @@ void PeopleCallsGenerator::Shutdown()
   m_log.Trace("Shutdown completed", Log::TraceLevel::Verbose);
 }
 
+void PeopleCallsGenerator::Serialize(CheckpointWriter& writer) const
+{
+  std::stringstream engineState;
+  engineState << m_randomEngine;
+
+  writer.Write(engineState.str());
+  writer.Write(m_generatedCalls);
+}
+
+bool PeopleCallsGenerator::Deserialize(CheckpointReader& reader)
+{
+  std::string state;
+
+  if (!reader.Read(state) || !reader.Read(m_generatedCalls))
+    return false;
+
+  std::stringstream engineState(state);
+  engineState >> m_randomEngine;
+
+  return !engineState.fail();
+}
+
 void PeopleCallsGenerator::RandomGeneratorThread::CycleFunction(PeopleCallsGenerator* peopleCallsGenerator)
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Generator);
+
   if (peopleCallsGenerator == nullptr || StopRequested())
     return;
 
   std::this_thread::sleep_for(2s); // arbitrary delay before start
 
-  unsigned int numberOfGeneratedCalls = 0;
-
-  const auto seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-  std::default_random_engine generator(seed);
+  auto& generator = peopleCallsGenerator->m_randomEngine;
 
   const std::uniform_int_distribution<Floors::FloorNumber> randomFloor(Floors::BottomFloor, Floors::TopFloor);
   const std::uniform_int_distribution<long long> randomDelay(MinDelayBetweenCalls, MaxDelayBetweenCalls);
@@ -76,31 +133,45 @@ void PeopleCallsGenerator::RandomGeneratorThread::CycleFunction(PeopleCallsGener
   do
   {
     std::shared_ptr<Call> call;
+    std::chrono::milliseconds delay;
 
-    do
     {
-      auto getStartFloor = std::bind(randomFloor, std::ref(generator));
-      auto getDestinationFloor = std::bind(randomFloor, std::ref(generator));
+      // The call is in the waiting people before the lock is released: a checkpoint sees it generated
+      std::lock_guard<InstrumentedMutex> lock(peopleCallsGenerator->m_mutex);
+
+      if (m_numberOfCalls != EndlessCalls && peopleCallsGenerator->m_generatedCalls >= m_numberOfCalls)
+        break;
+
+      do
+      {
+        auto getStartFloor = std::bind(randomFloor, std::ref(generator));
+        auto getDestinationFloor = std::bind(randomFloor, std::ref(generator));
 
-      call = std::make_shared<Call>(getStartFloor(), getDestinationFloor());
-    } while (!call->IsValid()); // only valid calls
+        call = std::make_shared<Call>(getStartFloor(), getDestinationFloor());
+      } while (!call->IsValid()); // only valid calls
 
-    peopleCallsGenerator->m_log.Trace("Generated call " + call->ToString());
+      peopleCallsGenerator->m_log.Trace("Generated call " + call->ToString());
+      Metrics::Increment(Metrics::Get().m_callsGenerated);
 
-    const auto it = Floors::GetPeople().Insert(call);
+      Floors::GetPeople().Insert(call);
+      Journal::Record(Journal::EventType::CallCreated, Journal::NoElevator, call->GetStartFloor(), call->GetId(), static_cast<int>(call->GetDestinationFloor()));
+      TraceEvents::Instant("Call created", TraceEvents::NoElevator, call->GetStartFloor(), call->GetId());
+      ++peopleCallsGenerator->m_generatedCalls;
+
+      auto getDelay = std::bind(randomDelay, std::ref(generator));
+      delay = std::chrono::milliseconds(getDelay());
+    }
 
     // Async assign request
-    auto handle = std::async(std::launch::async, [peopleCallsGenerator, &it]() {peopleCallsGenerator->m_management.AssignCall(*it); });
+    auto handle = std::async(std::launch::async, [peopleCallsGenerator, call]() mutable {peopleCallsGenerator->m_management.AssignCall(call); });
 
     // Synch assign request
-    //m_management.AssignCall(*it);
+    //m_management.AssignCall(call);
 
-    ++numberOfGeneratedCalls;
-    if (m_numberOfCalls != EndlessCalls && numberOfGeneratedCalls >= m_numberOfCalls)
+    if (m_numberOfCalls != EndlessCalls && peopleCallsGenerator->m_generatedCalls >= m_numberOfCalls)
       break;
 
-    auto getDelay = std::bind(randomDelay, std::ref(generator));
-    std::this_thread::sleep_for(std::chrono::milliseconds(getDelay()));
+    std::this_thread::sleep_for(delay);
 
   } while (!StopRequested());
 
@@ -109,11 +180,12 @@ void PeopleCallsGenerator::RandomGeneratorThread::CycleFunction(PeopleCallsGener
 
 void PeopleCallsGenerator::FixedGeneratorThread::CycleFunction(PeopleCallsGenerator* peopleCallsGenerator)
 {
+  AllocStats::Scope allocationScope(AllocStats::Tag::Generator);
+
   if (peopleCallsGenerator == nullptr)
     return;
 
-  const auto seed = static_cast<unsigned int>(std::chrono::system_clock::now().time_since_epoch().count());
-  std::default_random_engine generator(seed);
+  auto& generator = peopleCallsGenerator->m_randomEngine;
 
   const std::uniform_int_distribution<long long> randomDelay(MinDelayBetweenCalls, MaxDelayBetweenCalls);
 
@@ -148,23 +220,210 @@ void PeopleCallsGenerator::FixedGeneratorThread::CycleFunction(PeopleCallsGenera
     std::make_shared<Call>(bottomFloor, 9)
   };
 
-  for (const auto& call : calls)
+  unsigned int index = 0;
+
+  for (auto& call : calls)
   {
-    if (!call->IsValid())
-      continue;
+    if (StopRequested())
+      break;
+
+    std::chrono::milliseconds delay;
 
-    peopleCallsGenerator->m_log.Trace("Asking call assignment " + call->ToString());
+    {
+      std::lock_guard<InstrumentedMutex> lock(peopleCallsGenerator->m_mutex);
 
-    const auto it = Floors::GetPeople().Insert(call);
+      // After a restore the calls already generated are skipped
+      if (index++ < peopleCallsGenerator->m_generatedCalls)
+        continue;
+
+      ++peopleCallsGenerator->m_generatedCalls;
+
+      if (!call->IsValid())
+        continue;
+
+      peopleCallsGenerator->m_log.Trace("Asking call assignment " + call->ToString());
+      Metrics::Increment(Metrics::Get().m_callsGenerated);
+
+      Floors::GetPeople().Insert(call);
+      Journal::Record(Journal::EventType::CallCreated, Journal::NoElevator, call->GetStartFloor(), call->GetId(), static_cast<int>(call->GetDestinationFloor()));
+      TraceEvents::Instant("Call created", TraceEvents::NoElevator, call->GetStartFloor(), call->GetId());
+
+      auto getDelay = std::bind(randomDelay, std::ref(generator));
+      delay = std::chrono::milliseconds(getDelay());
+    }
 
     // Async assign request
-    auto handle = std::async(std::launch::async, [peopleCallsGenerator, &it]() {peopleCallsGenerator->m_management.AssignCall(*it); });
+    auto handle = std::async(std::launch::async, [peopleCallsGenerator, &call]() {peopleCallsGenerator->m_management.AssignCall(call); });
 
     // Synch assign request
-    //m_management.AssignCall(*it);
+    //m_management.AssignCall(call);
 
-    auto getDelay = std::bind(randomDelay, std::ref(generator));
-    std::this_thread::sleep_for(std::chrono::milliseconds(getDelay()));
+    std::this_thread::sleep_for(delay);
   }
 }
 
+PeopleCallsGenerator::SocketIngressThread::SocketIngressThread(PeopleCallsGenerator* peopleCallsGenerator, const std::string& path) :
+  WorkerThread<PeopleCallsGenerator>(peopleCallsGenerator),
+  m_path(path),
+  m_buffer(16 * MaxBatchBytes)
+{
+  m_batch.reserve(MaxBatchSize);
+}
+
+void PeopleCallsGenerator::SocketIngressThread::CycleFunction(PeopleCallsGenerator* peopleCallsGenerator)
+{
+  AllocStats::Scope allocationScope(AllocStats::Tag::Generator);
+
+  if (peopleCallsGenerator == nullptr || StopRequested())
+    return;
+
+  auto& log = peopleCallsGenerator->m_log;
+
+#ifdef _WIN32
+  log.Trace("Socket calls ingress not available on this platform", Log::TraceLevel::Error);
+#else
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (m_path.size() >= sizeof(address.sun_path))
+  {
+    log.Trace("Socket path too long: " + m_path, Log::TraceLevel::Error);
+    return;
+  }
+
+  std::memcpy(address.sun_path, m_path.c_str(), m_path.size());
+
+  const auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  unlink(m_path.c_str()); // left by a previous run
+
+  if (listener < 0 || bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 4) != 0)
+  {
+    log.Trace("Cannot listen on " + m_path, Log::TraceLevel::Error);
+
+    if (listener >= 0)
+      close(listener);
+
+    return;
+  }
+
+  log.Trace("Waiting for calls on " + m_path);
+
+  int client = -1;
+  std::size_t received = 0;
+
+  while (!StopRequested())
+  {
+    const auto handle = client >= 0 ? client : listener;
+
+    fd_set readSet;
+    FD_ZERO(&readSet);
+    FD_SET(handle, &readSet);
+
+    timeval timeout{ 0, PollTimeoutMilliseconds * 1000 };
+
+    if (select(handle + 1, &readSet, nullptr, nullptr, &timeout) <= 0)
+      continue;
+
+    if (client < 0)
+    {
+      client = accept(listener, nullptr, nullptr);
+      received = 0;
+
+      if (client >= 0)
+        log.Trace("Calls source connected", Log::TraceLevel::Verbose);
+
+      continue;
+    }
+
+    const auto bytes = recv(client, m_buffer.data() + received, m_buffer.size() - received, 0);
+
+    if (bytes <= 0)
+    {
+      log.Trace("Calls source disconnected", Log::TraceLevel::Verbose);
+      close(client);
+      client = -1;
+      continue;
+    }
+
+    received += static_cast<std::size_t>(bytes);
+
+    // Every complete batch is dispatched, a partial one waits for the next read
+    std::size_t offset = 0;
+
+    while (received - offset >= BatchHeaderSize)
+    {
+      const std::size_t numberOfCalls = ReadUInt16(m_buffer.data() + offset);
+
+      if (numberOfCalls > MaxBatchSize)
+      {
+        log.Trace("Batch of " + std::to_string(numberOfCalls) + " calls exceeds the maximum, connection closed", Log::TraceLevel::Error);
+        close(client);
+        client = -1;
+        offset = received;
+        break;
+      }
+
+      const auto batchSize = BatchHeaderSize + numberOfCalls * CallRecordSize;
+
+      if (received - offset < batchSize)
+        break;
+
+      Dispatch(peopleCallsGenerator, m_buffer.data() + offset + BatchHeaderSize, numberOfCalls);
+      offset += batchSize;
+    }
+
+    std::memmove(m_buffer.data(), m_buffer.data() + offset, received - offset);
+    received -= offset;
+  }
+
+  if (client >= 0)
+    close(client);
+
+  close(listener);
+  unlink(m_path.c_str());
+#endif
+}
+
+/**
+ * \brief Create the calls of a batch, insert them in the waiting people and assign them.
+ */
+void PeopleCallsGenerator::SocketIngressThread::Dispatch(PeopleCallsGenerator* peopleCallsGenerator, const unsigned char* records, const std::size_t numberOfCalls)
+{
+  std::size_t discarded = 0;
+
+  {
+    // The batch is in the waiting people before the lock is released: a checkpoint sees it generated
+    std::lock_guard<InstrumentedMutex> lock(peopleCallsGenerator->m_mutex);
+
+    for (std::size_t index = 0; index < numberOfCalls; ++index)
+    {
+      const auto record = records + index * CallRecordSize;
+      const Floors::FloorNumber startFloor = ReadUInt16(record);
+      const Floors::FloorNumber destinationFloor = ReadUInt16(record + 2);
+
+      if (!Floors::IsValid(startFloor) || !Floors::IsValid(destinationFloor) || startFloor == destinationFloor)
+      {
+        ++discarded;
+        continue;
+      }
+
+      m_batch.push_back(std::make_shared<Call>(startFloor, destinationFloor));
+      Journal::Record(Journal::EventType::CallCreated, Journal::NoElevator, startFloor, m_batch.back()->GetId(), static_cast<int>(destinationFloor));
+      TraceEvents::Instant("Call created", TraceEvents::NoElevator, startFloor, m_batch.back()->GetId());
+    }
+
+    Floors::GetPeople().Insert(m_batch);
+
+    peopleCallsGenerator->m_generatedCalls += static_cast<unsigned int>(m_batch.size());
+    Metrics::Increment(Metrics::Get().m_callsGenerated, m_batch.size());
+  }
+
+  peopleCallsGenerator->m_log.Trace("Received " + std::to_string(m_batch.size()) + " calls", Log::TraceLevel::Verbose);
+
+  if (discarded > 0)
+    peopleCallsGenerator->m_log.Trace("Discarded " + std::to_string(discarded) + " invalid calls", Log::TraceLevel::Warning);
+
+  peopleCallsGenerator->m_management.AssignCalls(m_batch);
+  m_batch.clear(); // the capacity is kept for the next batch
+}
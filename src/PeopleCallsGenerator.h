@@ -9,6 +9,12 @@
 
 #include "Log.h"
 #include "WorkerThread.h"
+#include "LockStats.h"
+
+#include <random>
+#include <memory>
+#include <string>
+#include <vector>
 
 class PeopleCallsGenerator final 
 {
@@ -37,6 +43,35 @@ private:
     void CycleFunction(PeopleCallsGenerator* peopleCallsGenerator) override;
   };
 
+  /**
+   * \brief Receives batches of calls from one client at a time on a Unix domain socket (not available on Windows).
+   *
+   * Framing of a batch, little endian: uint16 number of calls, then for every call the uint16 start floor
+   * and the uint16 destination floor. Invalid calls are discarded. A batch is inserted in the waiting people
+   * and dispatched with a single lock each, from this thread, and traced as a whole.
+   *
+   * Allocations left per call: the call with its shared count (one block) and its node in the waiting people,
+   * both made before taking the lock of the waiting people. The patience deadlines of the passengers, if enabled,
+   * are in a heap whose storage keeps its capacity. A call left pending is traced when it is assigned.
+   */
+  class SocketIngressThread final : public WorkerThread<PeopleCallsGenerator>
+  {
+  public:
+    explicit SocketIngressThread(PeopleCallsGenerator* peopleCallsGenerator, const std::string& path);
+
+  protected:
+    void CycleFunction(PeopleCallsGenerator* peopleCallsGenerator) override;
+
+  private:
+    void Dispatch(PeopleCallsGenerator* peopleCallsGenerator, const unsigned char* records, const std::size_t numberOfCalls);
+
+  private:
+    std::string m_path;
+
+    std::vector<unsigned char> m_buffer;          // received bytes, at most a partial batch is left between reads
+    std::vector<std::shared_ptr<class Call>> m_batch;  // reused for every batch
+  };
+
 public:
   explicit PeopleCallsGenerator(class Management& management);
   PeopleCallsGenerator() = delete;
@@ -52,12 +87,29 @@ public:
 public:
   void StartRandom(const unsigned int numberOfCalls = static_cast<unsigned int>(-1));
   void StartFixed();
+  void StartSocket(const std::string& path);
 
   void Shutdown();
 
+  /**
+   * \brief Block the generator before its next call, until Resume is called (by the same thread).
+   */
+  void Pause() { m_mutex.lock(); }
+  void Resume() { m_mutex.unlock(); }
+
+  /**
+   * \brief Write and read the random engine state and the number of generated calls. The generator must be paused.
+   */
+  void Serialize(class CheckpointWriter& writer) const;
+  bool Deserialize(class CheckpointReader& reader);
+
 private:
   class Management& m_management;
 
+  std::default_random_engine m_randomEngine;
+  unsigned int m_generatedCalls = 0;
+  InstrumentedMutex m_mutex{ "Generator" }; // generation of a call, random engine and counter
+
   Log m_log;
 
   std::unique_ptr<WorkerThread<PeopleCallsGenerator>> m_generatorThread;
@@ -0,0 +1,171 @@
+#include "SharedMemory.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool SharedMemory::Create(const std::string& name, const std::size_t size, const bool exclusive)
+{
+  Close();
+
+  const auto size64 = static_cast<unsigned long long>(size);
+
+  m_handle = CreateFileMappingA(
+    INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+    static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFULL),
+    ("Local\\" + name).c_str());
+
+  if (m_handle == nullptr)
+    return false;
+
+  // A named mapping exists only while some process holds a handle to it
+  if (exclusive && GetLastError() == ERROR_ALREADY_EXISTS)
+  {
+    Close();
+    return false;
+  }
+
+  m_address = MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+  if (m_address == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  m_size = size;
+  return true;
+}
+
+bool SharedMemory::MapFile(const std::string& fileName, const std::size_t size)
+{
+  Close();
+
+  auto file = CreateFileA(
+    fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+    nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  m_file = file;
+
+  const auto size64 = static_cast<unsigned long long>(size);
+
+  // The mapping extends the file to the requested size
+  m_handle = CreateFileMappingA(
+    file, nullptr, PAGE_READWRITE,
+    static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFULL), nullptr);
+
+  if (m_handle == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  m_address = MapViewOfFile(m_handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+  if (m_address == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  m_size = size;
+  return true;
+}
+
+void SharedMemory::Close()
+{
+  if (m_address != nullptr)
+    UnmapViewOfFile(m_address);
+
+  if (m_handle != nullptr)
+    CloseHandle(m_handle);
+
+  if (m_file != nullptr)
+    CloseHandle(m_file);
+
+  m_address = nullptr;
+  m_handle = nullptr;
+  m_file = nullptr;
+  m_size = 0;
+}
+
+#else
+
+bool SharedMemory::Create(const std::string& name, const std::size_t size, const bool exclusive)
+{
+  Close();
+
+  m_descriptor = shm_open(("/" + name).c_str(), O_CREAT | O_RDWR, 0644);
+
+  // The segment survives the processes: the lock, released when the holder exits, tells if it is in use
+  if (exclusive && m_descriptor >= 0 && flock(m_descriptor, LOCK_EX | LOCK_NB) != 0)
+  {
+    Close();
+    return false;
+  }
+
+  return Map(size);
+}
+
+bool SharedMemory::MapFile(const std::string& fileName, const std::size_t size)
+{
+  Close();
+
+  m_descriptor = open(fileName.c_str(), O_CREAT | O_RDWR, 0644);
+
+  return Map(size);
+}
+
+/**
+ * \brief Resize and map the open descriptor.
+ */
+bool SharedMemory::Map(const std::size_t size)
+{
+  if (m_descriptor < 0)
+    return false;
+
+  if (ftruncate(m_descriptor, static_cast<off_t>(size)) != 0)
+  {
+    Close();
+    return false;
+  }
+
+  auto address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, m_descriptor, 0);
+
+  if (address == MAP_FAILED)
+  {
+    Close();
+    return false;
+  }
+
+  m_address = address;
+  m_size = size;
+  return true;
+}
+
+void SharedMemory::Close()
+{
+  if (m_address != nullptr)
+    munmap(m_address, m_size);
+
+  if (m_descriptor >= 0)
+    close(m_descriptor);
+
+  m_address = nullptr;
+  m_descriptor = -1;
+  m_size = 0;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/**********************************************************************************
+*        File: SharedMemory.h
+* Description: Implements a named shared memory segment or a memory mapped file.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes:
+**********************************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/**
+ * \brief Named memory segment that other processes can map (POSIX shared memory or Windows file mapping),
+ * or a file mapped in memory: its content survives the process.
+ */
+class SharedMemory final
+{
+public:
+  SharedMemory() = default;
+  ~SharedMemory() { Close(); }
+
+  SharedMemory(const SharedMemory&) = delete;
+  SharedMemory(SharedMemory&&) = delete;
+
+  SharedMemory& operator=(const SharedMemory&) = delete;
+  SharedMemory& operator=(SharedMemory&&) = delete;
+
+public:
+  /**
+   * \brief Create (or open, if it already exists) and map a named segment, read/write.
+   * \param name Name of the segment, without any platform specific prefix.
+   * \param size Size of the segment in bytes.
+   * \param exclusive Fail if another process holds the segment, e.g. another instance writing it.
+   *        A segment left by a process already exited is reused.
+   * \return 'true' if the segment is mapped, 'false' otherwise.
+   */
+  bool Create(const std::string& name, const std::size_t size, const bool exclusive = false);
+
+  /**
+   * \brief Map a file read/write, creating it if it does not exist. The file is resized to the passed size.
+   * \param fileName Path of the file.
+   * \param size Size of the mapping in bytes.
+   * \return 'true' if the file is mapped, 'false' otherwise.
+   */
+  bool MapFile(const std::string& fileName, const std::size_t size);
+
+  /**
+   * \brief Unmap the segment. The segment (or the file) itself is left in place for the other processes.
+   */
+  void Close();
+
+  void* GetAddress() const { return m_address; }
+  std::size_t GetSize() const { return m_size; }
+
+private:
+#ifndef _WIN32
+  bool Map(const std::size_t size);
+#endif
+
+private:
+  void* m_address = nullptr;
+  std::size_t m_size = 0;
+
+#ifdef _WIN32
+  void* m_handle = nullptr;
+  void* m_file = nullptr;
+#else
+  int m_descriptor = -1;
+#endif
+};
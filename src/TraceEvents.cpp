@@ -0,0 +1,152 @@
+#include "TraceEvents.h"
+
+#include "Log.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace Configuration::TraceEvents;
+
+namespace
+{
+  struct Event
+  {
+    const char* m_name;
+    std::int64_t m_time;
+    std::int64_t m_duration;
+    std::uint64_t m_callId;
+    unsigned int m_elevator;
+    unsigned int m_floor;
+    char m_phase;
+  };
+
+  struct Buffer
+  {
+    std::vector<Event> m_events;
+    std::uint64_t m_dropped = 0;
+  };
+
+  /**
+   * \brief The buffers of all the threads, kept after the threads exit.
+   */
+  struct Buffers
+  {
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<Buffer>> m_buffers;
+  };
+
+  Buffers& GetBuffers()
+  {
+    static Buffers buffers;
+    return buffers;
+  }
+
+  Buffer& GetThreadBuffer()
+  {
+    thread_local Buffer* buffer = nullptr;
+
+    if (buffer == nullptr)
+    {
+      auto& buffers = GetBuffers();
+      std::lock_guard<std::mutex> lock(buffers.m_mutex);
+
+      buffers.m_buffers.push_back(std::make_unique<Buffer>());
+      buffer = buffers.m_buffers.back().get();
+    }
+
+    return *buffer;
+  }
+
+  unsigned int Track(const unsigned int elevator)
+  {
+    return elevator == TraceEvents::NoElevator ? 0 : elevator + 1;
+  }
+}
+
+std::int64_t TraceEvents::Now()
+{
+  static const auto origin = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void TraceEvents::Record(const char* name, const char phase, const unsigned int elevator, const unsigned int floor,
+  const std::uint64_t callId, const std::int64_t time, const std::int64_t duration)
+{
+  auto& buffer = GetThreadBuffer();
+
+  if (buffer.m_events.size() >= MaxEventsPerThread)
+  {
+    ++buffer.m_dropped;
+    return;
+  }
+
+  buffer.m_events.push_back(Event{ name, time, duration, callId, elevator, floor, phase });
+}
+
+bool TraceEvents::Write(const std::string& fileName)
+{
+  Log log("TraceEvents");
+
+  std::ofstream file(fileName, std::ios::trunc);
+
+  if (!file)
+  {
+    log.Trace("Cannot create " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Elevator\"}},\n";
+  file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Dispatch\"}}";
+
+  for (unsigned int elevator = 0; elevator < Configuration::Building::NumberOfElevators; ++elevator)
+  {
+    file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Track(elevator)
+      << ",\"args\":{\"name\":\"Elevator " << static_cast<char>('A' + elevator) << "\"}}";
+  }
+
+  std::size_t written = 0;
+  std::uint64_t dropped = 0;
+
+  auto& buffers = GetBuffers();
+  std::lock_guard<std::mutex> lock(buffers.m_mutex);
+
+  for (const auto& buffer : buffers.m_buffers)
+  {
+    for (const auto& event : buffer->m_events)
+    {
+      file << ",\n{\"name\":\"" << event.m_name << "\",\"ph\":\"" << event.m_phase << "\",\"pid\":1,\"tid\":" << Track(event.m_elevator)
+        << ",\"ts\":" << event.m_time;
+
+      if (event.m_phase == 'X')
+        file << ",\"dur\":" << event.m_duration;
+      else
+        file << ",\"s\":\"t\"";
+
+      file << ",\"args\":{\"floor\":" << event.m_floor;
+
+      if (event.m_callId != 0)
+        file << ",\"call\":" << event.m_callId;
+
+      file << "}}";
+    }
+
+    written += buffer->m_events.size();
+    dropped += buffer->m_dropped;
+  }
+
+  file << "\n]}\n";
+  file.flush();
+
+  if (!file.good())
+  {
+    log.Trace("Error writing " + fileName, Log::TraceLevel::Error);
+    return false;
+  }
+
+  log.Trace("Trace events written: " + fileName + " (" + std::to_string(written) + " events, " + std::to_string(dropped) + " dropped)");
+  return true;
+}
@@ -0,0 +1,82 @@
+/**********************************************************************************
+*        File: TraceEvents.h
+* Description: Timeline of the elevators in the Chrome trace event format, to be
+*              inspected in Perfetto (ui.perfetto.dev) or chrome://tracing.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes: Every thread appends to its own buffer, without locks; the buffers are
+*              written to the file at shutdown, after all the threads are stopped.
+**********************************************************************************/
+
+#pragma once
+
+#include "Configuration.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * \brief One track per elevator plus a dispatch track, for the calls generated and not assigned yet.
+ * Spans are complete events ("X"): a timestamp is read when the span starts and one when it ends.
+ * Disabled in the configuration, the spans and the instant events compile to nothing.
+ */
+class TraceEvents final
+{
+public:
+  static constexpr unsigned int NoElevator = static_cast<unsigned int>(-1);
+
+  /**
+   * \brief Span of an elevator activity, from the construction to the destruction.
+   */
+  class Span final
+  {
+  public:
+    Span(const char* name, const unsigned int elevator, const unsigned int floor) :
+      m_name(name), m_elevator(elevator), m_floor(floor), m_start(Configuration::TraceEvents::Enabled ? Now() : 0) {}
+
+    ~Span()
+    {
+      if (Configuration::TraceEvents::Enabled)
+        Complete(m_name, m_elevator, m_floor, m_start, Now());
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+  private:
+    const char* m_name;
+    unsigned int m_elevator;
+    unsigned int m_floor;
+    std::int64_t m_start;
+  };
+
+public:
+  TraceEvents() = delete;
+
+  /**
+   * \brief Record an instant event.
+   * \param name Name of the event, a string literal: only the pointer is kept.
+   * \param elevator Index of the elevator, NoElevator for the dispatch track.
+   */
+  static void Instant(const char* name, const unsigned int elevator, const unsigned int floor, const std::uint64_t callId)
+  {
+    if (Configuration::TraceEvents::Enabled)
+      Record(name, 'i', elevator, floor, callId, Now(), 0);
+  }
+
+  /**
+   * \brief Write the events of all the threads. The threads recording events must be stopped.
+   */
+  static bool Write(const std::string& fileName);
+
+private:
+  /**
+   * \brief Microseconds since the first event.
+   */
+  static std::int64_t Now();
+
+  static void Complete(const char* name, const unsigned int elevator, const unsigned int floor, const std::int64_t start, const std::int64_t end)
+    { Record(name, 'X', elevator, floor, 0, start, end - start); }
+
+  static void Record(const char* name, const char phase, const unsigned int elevator, const unsigned int floor,
+    const std::uint64_t callId, const std::int64_t time, const std::int64_t duration);
+};
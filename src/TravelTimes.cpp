@@ -0,0 +1,84 @@
+#include "TravelTimes.h"
+
+#include "Configuration.h"
+
+#include <cmath>
+
+using namespace Configuration::Elevator;
+
+TravelTimes::TravelTimes()
+{
+  m_table.resize(Floors::TotalFloors * Floors::TotalFloors);
+
+  for (Floors::FloorNumber from = Floors::BottomFloor; Floors::IsValid(from); ++from)
+  {
+    for (Floors::FloorNumber to = Floors::BottomFloor; Floors::IsValid(to); ++to)
+    {
+      const auto seconds = RunTime(std::abs(Elevation(to) - Elevation(from)));
+      m_table[from * Floors::TotalFloors + to] = std::chrono::milliseconds(static_cast<long long>(std::lround(seconds * 1000.0)));
+    }
+  }
+}
+
+const TravelTimes& TravelTimes::GetInstance()
+{
+  static const TravelTimes travelTimes;
+  return travelTimes;
+}
+
+std::chrono::milliseconds TravelTimes::Get(const Floors::FloorNumber from, const Floors::FloorNumber to)
+{
+  if (!Floors::IsValid(from) || !Floors::IsValid(to))
+    return std::chrono::milliseconds::zero();
+
+  return GetInstance().m_table[from * Floors::TotalFloors + to];
+}
+
+double TravelTimes::Elevation(const Floors::FloorNumber floor)
+{
+  if (floor == Floors::BottomFloor || !Floors::IsValid(floor))
+    return 0.0;
+
+  return Configuration::Building::LobbyHeight + (floor - 1U) * Configuration::Building::FloorHeight;
+}
+
+/**
+ * \brief Time (s) to cover a distance from standstill to standstill.
+ * The acceleration ramps up and down at the maximum jerk, so the acceleration and deceleration
+ * phases are symmetric and cover a distance of (peak velocity * phase time / 2) each.
+ */
+double TravelTimes::RunTime(const double distance)
+{
+  if (distance <= 0.0)
+    return 0.0;
+
+  // Time to reach a velocity from standstill (or to stop from it)
+  const auto accelerationTime = [](const double velocity)
+  {
+    return velocity * Jerk >= Acceleration * Acceleration
+      ? velocity / Acceleration + Acceleration / Jerk // the maximum acceleration is reached
+      : 2.0 * std::sqrt(velocity / Jerk);            // the acceleration ramps up and immediately down
+  };
+
+  const auto rampTime = accelerationTime(MaxSpeed);
+  const auto rampsDistance = MaxSpeed * rampTime; // acceleration + deceleration
+
+  if (rampsDistance <= distance)
+    return 2.0 * rampTime + (distance - rampsDistance) / MaxSpeed;
+
+  // Short run: the maximum speed is never reached, search the peak velocity
+  auto low = 0.0;
+  auto high = MaxSpeed;
+
+  for (auto iteration = 0; iteration < 64; ++iteration)
+  {
+    const auto peak = (low + high) / 2.0;
+
+    if (peak * accelerationTime(peak) < distance)
+      low = peak;
+    else
+      high = peak;
+  }
+
+  return 2.0 * accelerationTime(high);
+}
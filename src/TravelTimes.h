@@ -0,0 +1,55 @@
+/**********************************************************************************
+*        File: TravelTimes.h
+* Description: Kinematic model of the car and precomputed floor-to-floor travel times.
+*      Author: Emanuele Merlo (emanuele.merlo@gmail.com)
+*       Notes:
+**********************************************************************************/
+
+#pragma once
+
+#include "Floors.h"
+
+#include <chrono>
+#include <vector>
+
+/**
+ * \brief Floor-to-floor travel times of a jerk limited car (S-curve motion profile).
+ * The whole table is computed once, at the first use, from the kinematic parameters
+ * in Configuration; afterwards every lookup is O(1).
+ */
+class TravelTimes final
+{
+public:
+  TravelTimes(const TravelTimes&) = delete;
+  TravelTimes(TravelTimes&&) = delete;
+
+  TravelTimes& operator=(const TravelTimes&) = delete;
+  TravelTimes& operator=(TravelTimes&&) = delete;
+
+public:
+  /**
+   * \brief Get the table, building it if needed.
+   */
+  static const TravelTimes& GetInstance();
+
+  /**
+   * \brief Time for a run between two floors, from standstill to standstill.
+   * \param from Start floor.
+   * \param to Destination floor.
+   * \return Travel time; zero for invalid floors or if the floors are the same.
+   */
+  static std::chrono::milliseconds Get(const Floors::FloorNumber from, const Floors::FloorNumber to);
+
+  /**
+   * \brief Height (m) of a floor above the bottom floor.
+   */
+  static double Elevation(const Floors::FloorNumber floor);
+
+private:
+  TravelTimes();
+
+  static double RunTime(const double distance);
+
+private:
+  std::vector<std::chrono::milliseconds> m_table;
+};
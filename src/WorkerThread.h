@@ -9,7 +9,9 @@
 #pragma once
 
 #include <thread>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <atomic>
 #include <condition_variable>
 #include <cassert>
@@ -58,7 +60,15 @@ public:
       return; // already requested
 
     m_stopRequested = true;
-    Go();
+
+    {
+      // Under the lock: a wait in progress cannot miss the request. Not Go: the thread can be already ended
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopWait = true;
+    }
+
+    m_go.notify_one();
+    m_stopped.notify_all();
 
     if (m_thread != nullptr && m_thread->joinable())
       m_thread->join();
@@ -102,6 +112,16 @@ protected:
    */
   virtual void CycleFunction(T* owner) = 0;
 
+  /**
+   * \brief Wait inside the cycle function until a time point, woken at once by Stop.
+   * \return 'true' if the time point is reached, 'false' if the thread stop is requested.
+   */
+  bool WaitUntil(const std::chrono::steady_clock::time_point time)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return !m_stopped.wait_until(lock, time, [this]() { return StopRequested(); });
+  }
+
 private:
   void ThreadFunction()
   {
@@ -130,6 +150,7 @@ private:
 
   std::mutex m_mutex;
   std::condition_variable m_go;
+  std::condition_variable m_stopped;
   std::atomic_bool m_stopWait{ false };
 
   T* m_owner{ nullptr };